@@ -2,13 +2,15 @@
 
 CC = gcc
 CFLAGS = -Wall -Wextra -g -std=c99
+LDFLAGS = -pthread
 FLEX = flex
 BISON = bison
 
-# Archivos fuente
-SOURCES = parser.tab.c lex.yy.c xml_tree.c semantic_analyzer.c
+# Archivos fuente (comunes al compilador y a los benchmarks)
+SOURCES = parser.tab.c lex.yy.c xml_tree.c semantic_analyzer.c xpath_engine.c query_cache.c query_set.c compact_tree.c symbol_table.c xml_input.c arena.c simd_scan.c thread_pool.c batch.c xml_push.c
 OBJECTS = $(SOURCES:.c=.o)
 EXECUTABLE = xml_compiler.exe
+BENCH_EXECUTABLE = xml_bench.exe
 
 # Archivos de entrada
 LEXER_SRC = lexer.l
@@ -22,8 +24,17 @@ PARSER_OUTPUT = parser.tab.c parser.tab.h
 all: $(EXECUTABLE)
 
 # Compilar el ejecutable
-$(EXECUTABLE): $(OBJECTS)
-	$(CC) $(CFLAGS) -o $@ $(OBJECTS)
+$(EXECUTABLE): $(OBJECTS) xml_compiler.o
+	$(CC) $(CFLAGS) -o $@ $(OBJECTS) xml_compiler.o $(LDFLAGS)
+
+# Benchmarks y comprobaciones contra xpath_execute
+$(BENCH_EXECUTABLE): $(OBJECTS) xml_bench.o
+	$(CC) $(CFLAGS) -o $@ $(OBJECTS) xml_bench.o $(LDFLAGS)
+
+bench: $(BENCH_EXECUTABLE)
+
+test: $(BENCH_EXECUTABLE)
+	$(BENCH_EXECUTABLE) --test
 
 # Generar el analizador léxico
 $(LEXER_OUTPUT): $(LEXER_SRC)
@@ -38,10 +49,23 @@ $(PARSER_OUTPUT): $(PARSER_SRC)
 	$(CC) $(CFLAGS) -c $< -o $@
 
 # Dependencias especiales
-parser.tab.o: parser.tab.c parser.tab.h xml_tree.h semantic_analyzer.h
-lex.yy.o: lex.yy.c parser.tab.h
-xml_tree.o: xml_tree.c xml_tree.h
-semantic_analyzer.o: semantic_analyzer.c semantic_analyzer.h xml_tree.h
+parser.tab.o: parser.tab.c parser.tab.h xml_parser.h xml_tree.h semantic_analyzer.h xml_input.h xml_sax.h
+xml_compiler.o: xml_compiler.c xml_parser.h simd_scan.h batch.h xml_push.h xpath_engine.h query_cache.h
+xml_bench.o: xml_bench.c parser.tab.h xml_parser.h simd_scan.h xpath_engine.h query_cache.h query_set.h thread_pool.h compact_tree.h
+lex.yy.o: lex.yy.c parser.tab.h xml_parser.h simd_scan.h symbol_table.h
+xml_tree.o: xml_tree.c xml_tree.h arena.h symbol_table.h xml_input.h
+symbol_table.o: symbol_table.c symbol_table.h arena.h
+semantic_analyzer.o: semantic_analyzer.c semantic_analyzer.h xml_tree.h xml_sax.h compact_tree.h
+xpath_engine.o: xpath_engine.c xpath_engine.h query_cache.h xml_tree.h compact_tree.h thread_pool.h xml_input.h semantic_analyzer.h
+query_cache.o: query_cache.c query_cache.h xpath_engine.h xml_tree.h
+query_set.o: query_set.c query_set.h xpath_engine.h xml_tree.h symbol_table.h
+compact_tree.o: compact_tree.c compact_tree.h xml_tree.h
+xml_input.o: xml_input.c xml_input.h
+arena.o: arena.c arena.h
+simd_scan.o: simd_scan.c simd_scan.h
+thread_pool.o: thread_pool.c thread_pool.h
+batch.o: batch.c batch.h xml_parser.h thread_pool.h semantic_analyzer.h query_set.h
+xml_push.o: xml_push.c xml_push.h parser.tab.h xml_parser.h simd_scan.h
 
 # Asegurar que los archivos generados existan antes de compilar
 parser.tab.c: $(PARSER_SRC)
@@ -49,7 +73,7 @@ lex.yy.c: $(LEXER_SRC) parser.tab.h
 
 # Limpiar archivos generados
 clean:
-	del /f *.o $(LEXER_OUTPUT) $(PARSER_OUTPUT) $(EXECUTABLE) 2>nul || true
+	del /f *.o $(LEXER_OUTPUT) $(PARSER_OUTPUT) $(EXECUTABLE) $(BENCH_EXECUTABLE) 2>nul || true
 
 # Limpiar todo incluyendo archivos de backup
 distclean: clean
@@ -59,6 +83,8 @@ distclean: clean
 help:
 	@echo Uso del Makefile:
 	@echo   make all      - Compilar todo el proyecto
+	@echo   make bench    - Compilar los benchmarks (xml_bench.exe)
+	@echo   make test     - Comparar todas las vías de consulta con xpath_execute
 	@echo   make clean    - Limpiar archivos generados
 	@echo   make distclean - Limpiar todo
 	@echo   make help     - Mostrar esta ayuda
@@ -89,4 +115,4 @@ test-files:
 	@echo.
 	@echo Archivos de prueba generados: test1.xml, test2.xml
 
-.PHONY: all clean distclean help test-files
\ No newline at end of file
+.PHONY: all bench test clean distclean help test-files
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN sizeof(void*)
+
+// Inicializar arena vacía
+void arena_init(Arena *arena, size_t chunk_size) {
+    arena->head = NULL;
+    arena->chunk_size = chunk_size ? chunk_size : ARENA_DEFAULT_CHUNK;
+    arena->bytes_used = 0;
+    arena->bytes_reserved = 0;
+}
+
+// Reservar un bloque nuevo con al menos 'size' bytes libres
+static ArenaChunk* new_chunk(Arena *arena, size_t size) {
+    ArenaChunk *chunk = (ArenaChunk*)malloc(sizeof(ArenaChunk) + size);
+    if (!chunk) {
+        fprintf(stderr, "Error: memoria insuficiente en la arena\n");
+        exit(1);
+    }
+    chunk->size = size;
+    chunk->used = 0;
+    chunk->next = NULL;
+    arena->bytes_reserved += sizeof(ArenaChunk) + size;
+    return chunk;
+}
+
+// Asignar memoria sin alinear (cadenas)
+static void* arena_alloc_bytes(Arena *arena, size_t size) {
+    ArenaChunk *chunk = arena->head;
+
+    if (!chunk || chunk->size - chunk->used < size) {
+        if (size > arena->chunk_size / 4) {
+            // Bloque dedicado para asignaciones grandes: se enlaza detrás
+            // del bloque actual para no desperdiciar su espacio libre
+            ArenaChunk *big = new_chunk(arena, size);
+            big->used = size;
+            if (chunk) {
+                big->next = chunk->next;
+                chunk->next = big;
+            } else {
+                arena->head = big;
+            }
+            arena->bytes_used += size;
+            return big->data;
+        }
+
+        chunk = new_chunk(arena, arena->chunk_size);
+        chunk->next = arena->head;
+        arena->head = chunk;
+    }
+
+    void *ptr = chunk->data + chunk->used;
+    chunk->used += size;
+    arena->bytes_used += size;
+    return ptr;
+}
+
+// Asignar memoria alineada a puntero
+void* arena_alloc(Arena *arena, size_t size) {
+    ArenaChunk *chunk = arena->head;
+    if (chunk) {
+        size_t pad = (ARENA_ALIGN - (chunk->used % ARENA_ALIGN)) % ARENA_ALIGN;
+        if (chunk->size - chunk->used >= size + pad) {
+            chunk->used += pad;
+            arena->bytes_used += pad;
+        }
+    }
+    return arena_alloc_bytes(arena, size);
+}
+
+// Copiar 'len' bytes de una cadena a la arena, terminada en nulo
+char* arena_strndup(Arena *arena, const char *str, size_t len) {
+    char *copy = (char*)arena_alloc_bytes(arena, len + 1);
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+// Copiar una cadena a la arena
+char* arena_strdup(Arena *arena, const char *str) {
+    return arena_strndup(arena, str, strlen(str));
+}
+
+// Vaciar la arena conservando un bloque de tamaño normal para reutilizarlo
+// (modo por eventos: las cadenas ya entregadas dejan de ser válidas)
+void arena_reset(Arena *arena) {
+    ArenaChunk *keep = NULL;
+    ArenaChunk *chunk = arena->head;
+    while (chunk) {
+        ArenaChunk *next = chunk->next;
+        if (!keep && chunk->size == arena->chunk_size) {
+            keep = chunk;
+        } else {
+            arena->bytes_reserved -= sizeof(ArenaChunk) + chunk->size;
+            free(chunk);
+        }
+        chunk = next;
+    }
+    if (keep) {
+        keep->used = 0;
+        keep->next = NULL;
+    }
+    arena->head = keep;
+    arena->bytes_used = 0;
+}
+
+// Liberar toda la arena de una vez
+void arena_release(Arena *arena) {
+    ArenaChunk *chunk = arena->head;
+    while (chunk) {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->head = NULL;
+    arena->bytes_used = 0;
+    arena->bytes_reserved = 0;
+}
+
+// Inicializar pool de objetos de tamaño fijo
+void pool_init(Pool *pool, size_t item_size, size_t items_per_chunk) {
+    pool->head = NULL;
+    pool->item_size = (item_size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    pool->items_per_chunk = items_per_chunk ? items_per_chunk : 1024;
+    pool->count = 0;
+    pool->bytes_reserved = 0;
+}
+
+// Obtener un objeto del pool (memoria sin inicializar)
+void* pool_alloc(Pool *pool) {
+    PoolChunk *chunk = pool->head;
+
+    if (!chunk || chunk->used == pool->items_per_chunk) {
+        size_t bytes = sizeof(PoolChunk) + pool->item_size * pool->items_per_chunk;
+        chunk = (PoolChunk*)malloc(bytes);
+        if (!chunk) {
+            fprintf(stderr, "Error: memoria insuficiente en el pool\n");
+            exit(1);
+        }
+        chunk->used = 0;
+        chunk->next = pool->head;
+        pool->head = chunk;
+        pool->bytes_reserved += bytes;
+    }
+
+    void *item = chunk->data + chunk->used * pool->item_size;
+    chunk->used++;
+    pool->count++;
+    return item;
+}
+
+// Vaciar el pool conservando el bloque actual para reutilizarlo
+void pool_reset(Pool *pool) {
+    PoolChunk *keep = pool->head;
+    if (!keep) return;
+
+    PoolChunk *chunk = keep->next;
+    while (chunk) {
+        PoolChunk *next = chunk->next;
+        free(chunk);
+        pool->bytes_reserved -= sizeof(PoolChunk) + pool->item_size * pool->items_per_chunk;
+        chunk = next;
+    }
+    keep->used = 0;
+    keep->next = NULL;
+    pool->count = 0;
+}
+
+// Liberar todos los objetos del pool
+void pool_release(Pool *pool) {
+    PoolChunk *chunk = pool->head;
+    while (chunk) {
+        PoolChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    pool->head = NULL;
+    pool->count = 0;
+    pool->bytes_reserved = 0;
+}
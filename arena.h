@@ -0,0 +1,55 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Bloque de memoria de la arena
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;
+    size_t size;
+    size_t used;
+    char data[];
+} ArenaChunk;
+
+// Arena de asignación secuencial (bump allocator): las asignaciones
+// individuales no se liberan, toda la arena se libera de una sola vez
+typedef struct Arena {
+    ArenaChunk *head;      // Bloque actual (los anteriores quedan enlazados)
+    size_t chunk_size;     // Tamaño por defecto de cada bloque
+    size_t bytes_used;     // Bytes entregados por la arena
+    size_t bytes_reserved; // Bytes reservados con malloc
+} Arena;
+
+#define ARENA_DEFAULT_CHUNK (64 * 1024)
+
+// Bloque de un pool: elementos contiguos en orden de creación
+typedef struct PoolChunk {
+    struct PoolChunk *next;
+    size_t used;
+    char data[];
+} PoolChunk;
+
+// Pool de objetos de tamaño fijo (slab); se libera por bloques, O(bloques)
+typedef struct Pool {
+    PoolChunk *head;        // Bloque actual
+    size_t item_size;
+    size_t items_per_chunk;
+    size_t count;           // Objetos entregados
+    size_t bytes_reserved;
+} Pool;
+
+// Funciones de la arena
+void arena_init(Arena *arena, size_t chunk_size);
+void* arena_alloc(Arena *arena, size_t size);
+char* arena_strndup(Arena *arena, const char *str, size_t len);
+char* arena_strdup(Arena *arena, const char *str);
+void arena_reset(Arena *arena);
+void arena_release(Arena *arena);
+
+// Funciones del pool
+void pool_init(Pool *pool, size_t item_size, size_t items_per_chunk);
+void* pool_alloc(Pool *pool);
+void pool_reset(Pool *pool);
+void pool_release(Pool *pool);
+
+#endif
@@ -0,0 +1,235 @@
+#define _GNU_SOURCE  // strdup con -std=c99
+#include "batch.h"
+#include "xml_parser.h"
+#include "query_set.h"
+#include "thread_pool.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// Lista de archivos a analizar
+typedef struct BatchList {
+    BatchFile *files;
+    int count;
+    int capacity;
+} BatchList;
+
+// Trabajo de un archivo dentro del pool
+typedef struct BatchJob {
+    BatchFile *file;
+    BatchOptions *options;
+    const QuerySet *queries;    // Los planes de 'options' combinados
+} BatchJob;
+
+// Verificar extensión .xml
+static int has_xml_extension(const char *name) {
+    size_t len = strlen(name);
+    return len > 4 && strcmp(name + len - 4, ".xml") == 0;
+}
+
+// Agregar archivo a la lista
+static void add_file(BatchList *list, const char *path) {
+    if (list->count >= list->capacity) {
+        list->capacity = list->capacity == 0 ? 64 : list->capacity * 2;
+        list->files = (BatchFile*)realloc(list->files, list->capacity * sizeof(BatchFile));
+    }
+    BatchFile *file = &list->files[list->count++];
+    file->path = strdup(path);
+    file->status = -1;
+    file->bytes = 0;
+    file->seconds = 0;
+    file->query_matches = 0;
+    file->query_seconds = 0;
+    init_semantic_table(&file->table);
+}
+
+// Recorrer el directorio recursivamente buscando archivos .xml
+static void collect_files(BatchList *list, const char *dir) {
+    DIR *handle = opendir(dir);
+    if (!handle) {
+        perror(dir);
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(handle)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        size_t len = strlen(dir) + strlen(entry->d_name) + 2;
+        char *path = (char*)malloc(len);
+        size_t dir_len = strlen(dir);
+        if (dir_len > 0 && (dir[dir_len - 1] == '/' || dir[dir_len - 1] == '\\')) {
+            snprintf(path, len, "%s%s", dir, entry->d_name);
+        } else {
+            snprintf(path, len, "%s/%s", dir, entry->d_name);
+        }
+
+        struct stat st;
+        if (stat(path, &st) == 0) {
+            if (S_ISDIR(st.st_mode)) {
+                collect_files(list, path);
+            } else if (S_ISREG(st.st_mode) && has_xml_extension(entry->d_name)) {
+                add_file(list, path);
+            }
+        }
+        free(path);
+    }
+    closedir(handle);
+}
+
+static int compare_files(const void *a, const void *b) {
+    return strcmp(((const BatchFile*)a)->path, ((const BatchFile*)b)->path);
+}
+
+// Analizar un archivo: lexer, parser y análisis semántico en este hilo
+static void parse_file_task(void *arg, int worker) {
+    BatchJob *job = (BatchJob*)arg;
+    BatchFile *file = job->file;
+    (void)worker;
+
+    XMLParseContext ctx;
+    init_parse_context(&ctx);
+    ctx.use_mmap = job->options->use_mmap;
+    ctx.fast_path = job->options->fast_path;
+    ctx.verbose = 0;
+
+    // Sin consultas solo se necesita la tabla semántica: análisis por
+    // eventos, sin árbol
+    if (job->options->plan_count == 0) {
+        ctx.sax = &semantic_sax_handler;
+        ctx.sax_data = &ctx.semantic_table;
+    }
+
+    double start = xml_time_now();
+    file->status = parse_xml_file(&ctx, file->path);
+    file->seconds = xml_time_now() - start;
+    file->bytes = ctx.bytes_read;
+
+    // El conjunto es inmutable: todos los hilos lo comparten y cada archivo
+    // se recorre una sola vez para todas las consultas
+    file->query_matches = 0;
+    if (file->status == 1 && job->options->plan_count > 0) {
+        XPathResult **results = (XPathResult**)malloc(job->options->plan_count * sizeof(XPathResult*));
+        start = xml_time_now();
+        query_set_execute(job->queries, &ctx.document, results);
+        for (int i = 0; i < job->options->plan_count; i++) {
+            file->query_matches += results[i]->count;
+            free_xpath_result(results[i]);
+        }
+        file->query_seconds = xml_time_now() - start;
+        free(results);
+    }
+
+    // La tabla semántica sobrevive al documento para la combinación final
+    free_semantic_table(&file->table);
+    file->table = ctx.semantic_table;
+    free_xml_document(&ctx.document);
+}
+
+// Analizar todos los archivos con 'threads' hilos; devuelve el tiempo total
+static double process_files(BatchList *list, BatchOptions *options, const QuerySet *queries, int threads) {
+    BatchJob *jobs = (BatchJob*)malloc((list->count ? list->count : 1) * sizeof(BatchJob));
+    ThreadPool *pool = thread_pool_create(threads);
+
+    double start = xml_time_now();
+    for (int i = 0; i < list->count; i++) {
+        jobs[i].file = &list->files[i];
+        jobs[i].options = options;
+        jobs[i].queries = queries;
+        thread_pool_submit(pool, parse_file_task, &jobs[i]);
+    }
+    thread_pool_wait(pool);
+    double elapsed = xml_time_now() - start;
+
+    thread_pool_destroy(pool);
+    free(jobs);
+    return elapsed;
+}
+
+// Medir la escalabilidad con 1, 2, 4, ... hilos hasta el máximo pedido
+static void run_scaling(BatchList *list, BatchOptions *options, const QuerySet *queries, int max_threads,
+                        size_t bytes) {
+    printf("\nEscalabilidad (%d archivos, %.2f MB):\n", list->count, bytes / (1024.0 * 1024.0));
+    printf("  Hilos   Tiempo (ms)     MB/s   Aceleración   Eficiencia\n");
+
+    double base = 0;
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > max_threads) threads = max_threads;
+        double elapsed = process_files(list, options, queries, threads);
+        if (threads == 1) base = elapsed;
+        printf("  %5d  %12.3f  %7.2f  %10.2fx  %10.0f%%\n", threads, elapsed * 1000.0,
+               bytes / elapsed / (1024.0 * 1024.0), base / elapsed,
+               base / elapsed / threads * 100.0);
+        if (threads == max_threads) break;
+    }
+}
+
+// Modo por lotes
+int run_batch(const char *dir, BatchOptions *options) {
+    BatchList list = { NULL, 0, 0 };
+    collect_files(&list, dir);
+    qsort(list.files, list.count, sizeof(BatchFile), compare_files);
+
+    int threads = options->threads > 0 ? options->threads : thread_pool_default_threads();
+    printf("Modo por lotes: %d archivo(s) en %s, %d hilo(s)\n", list.count, dir, threads);
+
+    QuerySet *queries = options->plan_count > 0 ? query_set_compile(options->plans, options->plan_count) : NULL;
+    double elapsed = process_files(&list, options, queries, threads);
+
+    // Resultados por archivo y tabla combinada en orden de ruta
+    SemanticTable merged;
+    init_semantic_table(&merged);
+    int errors = 0;
+    size_t total_bytes = 0;
+    double query_seconds = 0;
+
+    printf("\n--- Resultados por archivo ---\n");
+    for (int i = 0; i < list.count; i++) {
+        BatchFile *file = &list.files[i];
+        const char *label = file->status == 1 ? "OK   " : (file->status == 0 ? "ERROR" : "E/S  ");
+        printf("[%s] %s - %d elemento(s), %d atributo(s), %zu bytes, %.3f ms\n", label, file->path,
+               file->table.total_elements, file->table.total_attributes,
+               file->bytes, file->seconds * 1000.0);
+        if (options->plan_count > 0 && file->status == 1) {
+            printf("        consultas: %ld nodo(s), %.3f ms\n", file->query_matches, file->query_seconds * 1000.0);
+            query_seconds += file->query_seconds;
+        }
+        if (file->status == 1) {
+            merge_semantic_table(&merged, &file->table);
+        } else {
+            errors++;
+        }
+        total_bytes += file->bytes;
+    }
+
+    printf("\n=== Tabla semántica combinada ===\n");
+    print_semantic_table(&merged);
+
+    printf("Archivos válidos: %d, con errores: %d\n", list.count - errors, errors);
+    if (elapsed > 0) {
+        printf("Tiempo total: %.3f ms (%.1f archivos/s, %.2f MB/s)\n", elapsed * 1000.0,
+               list.count / elapsed, total_bytes / elapsed / (1024.0 * 1024.0));
+    }
+
+    if (options->plan_count > 0) {
+        printf("Ejecución de %d consulta(s) compiladas (%d estados, un recorrido por archivo): %.3f ms en total\n",
+               options->plan_count, queries->state_count, query_seconds * 1000.0);
+    }
+
+    if (options->scaling && list.count > 0) {
+        run_scaling(&list, options, queries, threads, total_bytes);
+    }
+    free_query_set(queries);
+
+    free_semantic_table(&merged);
+    for (int i = 0; i < list.count; i++) {
+        free_semantic_table(&list.files[i].table);
+        free(list.files[i].path);
+    }
+    free(list.files);
+    return errors;
+}
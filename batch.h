@@ -0,0 +1,34 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+#include "semantic_analyzer.h"
+#include "xpath_engine.h"
+
+// Resultado del análisis de un archivo en modo por lotes
+typedef struct BatchFile {
+    char *path;
+    int status;             // 1 válido, 0 con errores, -1 no se pudo abrir
+    size_t bytes;
+    double seconds;
+    SemanticTable table;    // Tabla semántica del archivo
+    long query_matches;     // Nodos encontrados por todas las consultas
+    double query_seconds;   // Tiempo de ejecución de las consultas
+} BatchFile;
+
+// Opciones del modo por lotes
+typedef struct BatchOptions {
+    int threads;            // 0 = número de procesadores
+    int use_mmap;
+    int fast_path;
+    int scaling;            // Medir la escalabilidad de 1 a 'threads' hilos
+    XPathPlan **plans;      // Consultas compiladas que se ejecutan sobre cada archivo
+    int plan_count;         // (combinadas en un QuerySet que comparten los hilos)
+} BatchOptions;
+
+// Analizar todos los archivos .xml de un directorio (recursivo) en un pool
+// de hilos; imprime el resultado por archivo y la tabla semántica combinada.
+// Devuelve el número de archivos con errores
+int run_batch(const char *dir, BatchOptions *options);
+
+#endif
@@ -41,6 +41,7 @@ if exist parser.tab.c del parser.tab.c
 if exist parser.tab.h del parser.tab.h
 if exist *.o del *.o
 if exist xml_compiler.exe del xml_compiler.exe
+if exist xml_bench.exe del xml_bench.exe
 echo ✓ Archivos limpiados
 echo.
 
@@ -108,15 +109,118 @@ if %errorlevel% neq 0 (
     exit /b 1
 )
 
+echo Compilando query_cache.c...
+gcc -Wall -Wextra -g -std=c99 -c query_cache.c -o query_cache.o
+if %errorlevel% neq 0 (
+    echo ERROR: Fallo al compilar query_cache.c
+    pause
+    exit /b 1
+)
+
+echo Compilando query_set.c...
+gcc -Wall -Wextra -g -std=c99 -c query_set.c -o query_set.o
+if %errorlevel% neq 0 (
+    echo ERROR: Fallo al compilar query_set.c
+    pause
+    exit /b 1
+)
+
+echo Compilando compact_tree.c...
+gcc -Wall -Wextra -g -std=c99 -c compact_tree.c -o compact_tree.o
+if %errorlevel% neq 0 (
+    echo ERROR: Fallo al compilar compact_tree.c
+    pause
+    exit /b 1
+)
+
+echo Compilando symbol_table.c...
+gcc -Wall -Wextra -g -std=c99 -c symbol_table.c -o symbol_table.o
+if %errorlevel% neq 0 (
+    echo ERROR: Fallo al compilar symbol_table.c
+    pause
+    exit /b 1
+)
+
+echo Compilando xml_input.c...
+gcc -Wall -Wextra -g -std=c99 -c xml_input.c -o xml_input.o
+if %errorlevel% neq 0 (
+    echo ERROR: Fallo al compilar xml_input.c
+    pause
+    exit /b 1
+)
+
+echo Compilando arena.c...
+gcc -Wall -Wextra -g -std=c99 -c arena.c -o arena.o
+if %errorlevel% neq 0 (
+    echo ERROR: Fallo al compilar arena.c
+    pause
+    exit /b 1
+)
+
+echo Compilando simd_scan.c...
+gcc -Wall -Wextra -g -std=c99 -c simd_scan.c -o simd_scan.o
+if %errorlevel% neq 0 (
+    echo ERROR: Fallo al compilar simd_scan.c
+    pause
+    exit /b 1
+)
+
+echo Compilando thread_pool.c...
+gcc -Wall -Wextra -g -std=c99 -c thread_pool.c -o thread_pool.o
+if %errorlevel% neq 0 (
+    echo ERROR: Fallo al compilar thread_pool.c
+    pause
+    exit /b 1
+)
+
+echo Compilando batch.c...
+gcc -Wall -Wextra -g -std=c99 -c batch.c -o batch.o
+if %errorlevel% neq 0 (
+    echo ERROR: Fallo al compilar batch.c
+    pause
+    exit /b 1
+)
+
+echo Compilando xml_push.c...
+gcc -Wall -Wextra -g -std=c99 -c xml_push.c -o xml_push.o
+if %errorlevel% neq 0 (
+    echo ERROR: Fallo al compilar xml_push.c
+    pause
+    exit /b 1
+)
+
+echo Compilando xml_compiler.c...
+gcc -Wall -Wextra -g -std=c99 -c xml_compiler.c -o xml_compiler.o
+if %errorlevel% neq 0 (
+    echo ERROR: Fallo al compilar xml_compiler.c
+    pause
+    exit /b 1
+)
+
+echo Compilando xml_bench.c...
+gcc -Wall -Wextra -g -std=c99 -c xml_bench.c -o xml_bench.o
+if %errorlevel% neq 0 (
+    echo ERROR: Fallo al compilar xml_bench.c
+    pause
+    exit /b 1
+)
+
 echo ✓ Todos los archivos objeto compilados
 
 REM Enlazar archivos objeto en un ejecutable
 echo Enlazando archivos objeto...
-gcc -o xml_compiler.exe parser.tab.o lex.yy.o xml_tree.o semantic_analyzer.o xpath_engine.o
+gcc -o xml_compiler.exe xml_compiler.o parser.tab.o lex.yy.o xml_tree.o semantic_analyzer.o xpath_engine.o query_cache.o query_set.o compact_tree.o symbol_table.o xml_input.o arena.o simd_scan.o thread_pool.o batch.o xml_push.o -pthread
 if %errorlevel% neq 0 (
     echo ERROR: Fallo al enlazar xml_compiler.exe
     pause
     exit /b 1
 )
 
-echo ✓ Compilación completa: xml_compiler.exe generado correctamente.
+gcc -o xml_bench.exe xml_bench.o parser.tab.o lex.yy.o xml_tree.o semantic_analyzer.o xpath_engine.o query_cache.o query_set.o compact_tree.o symbol_table.o xml_input.o arena.o simd_scan.o thread_pool.o batch.o xml_push.o -pthread
+if %errorlevel% neq 0 (
+    echo ERROR: Fallo al enlazar xml_bench.exe
+    pause
+    exit /b 1
+)
+
+echo ✓ Compilación completa: xml_compiler.exe y xml_bench.exe generados correctamente.
@@ -0,0 +1,182 @@
+#include "compact_tree.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Copiar una cadena al bloque de textos y devolver su inicio
+static uint32_t append_text(CompactTree *tree, size_t *used, const char *str) {
+    size_t len = strlen(str) + 1;
+    uint32_t start = (uint32_t)*used;
+    memcpy(tree->text + *used, str, len);
+    *used += len;
+    return start;
+}
+
+// Construir el árbol compacto: un recorrido para medir y otro para llenar
+void compact_tree_build(CompactTree *tree, XMLDocument *doc) {
+    memset(tree, 0, sizeof(CompactTree));
+    tree->names = &doc->names;
+
+    XMLNode *root = doc->root;
+    XMLTreeWalker walker;
+    XMLNode *node;
+    size_t nodes = 0, attrs = 0, text_size = 0;
+
+    xml_walker_init(&walker, root);
+    while ((node = xml_walker_next(&walker))) {
+        nodes++;
+        if (node->type == NODE_ELEMENT) {
+            if (node->attributes) {
+                for (Attribute *attr = node->attributes->first; attr; attr = attr->next) {
+                    attrs++;
+                    text_size += strlen(attr->value) + 1;
+                }
+            }
+        } else {
+            text_size += strlen(node->content) + 1;
+        }
+    }
+
+    tree->node_count = (uint32_t)nodes;
+    tree->type = (uint8_t*)malloc(nodes ? nodes : 1);
+    tree->name = (uint32_t*)malloc((nodes ? nodes : 1) * sizeof(uint32_t));
+    tree->first_child = (uint32_t*)malloc((nodes ? nodes : 1) * sizeof(uint32_t));
+    tree->next_sibling = (uint32_t*)malloc((nodes ? nodes : 1) * sizeof(uint32_t));
+    tree->parent = (uint32_t*)malloc((nodes ? nodes : 1) * sizeof(uint32_t));
+    tree->span_start = (uint32_t*)malloc((nodes ? nodes : 1) * sizeof(uint32_t));
+    tree->span_length = (uint32_t*)malloc((nodes ? nodes : 1) * sizeof(uint32_t));
+    tree->attr_count = (uint32_t)attrs;
+    tree->attr_name = (uint32_t*)malloc((attrs ? attrs : 1) * sizeof(uint32_t));
+    tree->attr_value = (uint32_t*)malloc((attrs ? attrs : 1) * sizeof(uint32_t));
+    tree->text = (char*)malloc(text_size ? text_size : 1);
+    tree->text_size = text_size;
+
+    // Pila por profundidad: elemento abierto y su último hijo enlazado
+    int stack_size = 64;
+    uint32_t *open = (uint32_t*)malloc(stack_size * sizeof(uint32_t));
+    uint32_t *last = (uint32_t*)malloc(stack_size * sizeof(uint32_t));
+
+    uint32_t index = 0, attr_index = 0;
+    size_t text_used = 0;
+    int leaving, depth;
+
+    xml_walker_init(&walker, root);
+    while ((node = xml_walker_step(&walker, &leaving, &depth))) {
+        if (leaving) continue;
+
+        if (depth >= stack_size) {
+            stack_size *= 2;
+            open = (uint32_t*)realloc(open, stack_size * sizeof(uint32_t));
+            last = (uint32_t*)realloc(last, stack_size * sizeof(uint32_t));
+        }
+
+        uint32_t parent = depth > 0 ? open[depth - 1] : COMPACT_NONE;
+        tree->type[index] = (uint8_t)node->type;
+        tree->parent[index] = parent;
+        tree->first_child[index] = COMPACT_NONE;
+        tree->next_sibling[index] = COMPACT_NONE;
+        if (depth > 0) {
+            if (last[depth - 1] == COMPACT_NONE) {
+                tree->first_child[parent] = index;
+            } else {
+                tree->next_sibling[last[depth - 1]] = index;
+            }
+            last[depth - 1] = index;
+        }
+        open[depth] = index;
+        last[depth] = COMPACT_NONE;
+
+        if (node->type == NODE_ELEMENT) {
+            tree->name[index] = node->name_id;
+            tree->span_start[index] = attr_index;
+            tree->span_length[index] = 0;
+            if (node->attributes) {
+                for (Attribute *attr = node->attributes->first; attr; attr = attr->next) {
+                    tree->attr_name[attr_index] = attr->name_id;
+                    tree->attr_value[attr_index] = append_text(tree, &text_used, attr->value);
+                    attr_index++;
+                    tree->span_length[index]++;
+                }
+            }
+        } else {
+            tree->name[index] = SYMBOL_NONE;
+            tree->span_length[index] = (uint32_t)strlen(node->content);
+            tree->span_start[index] = append_text(tree, &text_used, node->content);
+        }
+        index++;
+    }
+
+    free(open);
+    free(last);
+}
+
+void free_compact_tree(CompactTree *tree) {
+    free(tree->type);
+    free(tree->name);
+    free(tree->first_child);
+    free(tree->next_sibling);
+    free(tree->parent);
+    free(tree->span_start);
+    free(tree->span_length);
+    free(tree->attr_name);
+    free(tree->attr_value);
+    free(tree->text);
+    memset(tree, 0, sizeof(CompactTree));
+}
+
+// Bytes de los arreglos de nodos y atributos
+size_t compact_tree_node_memory(CompactTree *tree) {
+    size_t per_node = sizeof(uint8_t) + 6 * sizeof(uint32_t);
+    return tree->node_count * per_node + tree->attr_count * 2 * sizeof(uint32_t);
+}
+
+// Buscar el ID de un nombre en la tabla de símbolos del documento
+uint32_t compact_name_id(CompactTree *tree, const char *name) {
+    return symbol_lookup(tree->names, name);
+}
+
+const char* compact_node_name(CompactTree *tree, uint32_t node) {
+    return symbol_name(tree->names, tree->name[node]);
+}
+
+const char* compact_node_text(CompactTree *tree, uint32_t node) {
+    return tree->type[node] == NODE_ELEMENT ? NULL : tree->text + tree->span_start[node];
+}
+
+// En preorden el subárbol termina donde empieza el siguiente hermano del
+// nodo o, si no tiene, el de su ancestro más cercano que lo tenga
+uint32_t compact_subtree_end(CompactTree *tree, uint32_t node) {
+    while (node != COMPACT_NONE) {
+        if (tree->next_sibling[node] != COMPACT_NONE) {
+            return tree->next_sibling[node];
+        }
+        node = tree->parent[node];
+    }
+    return tree->node_count;
+}
+
+// Inicializar resultado
+CompactResult* init_compact_result(void) {
+    CompactResult *result = (CompactResult*)malloc(sizeof(CompactResult));
+    result->nodes = NULL;
+    result->count = 0;
+    result->capacity = 0;
+    return result;
+}
+
+// Agregar nodo al resultado
+void add_compact_result(CompactResult *result, uint32_t node) {
+    if (result->count >= result->capacity) {
+        result->capacity = result->capacity == 0 ? 10 : result->capacity * 2;
+        result->nodes = (uint32_t*)realloc(result->nodes, result->capacity * sizeof(uint32_t));
+    }
+    result->nodes[result->count++] = node;
+}
+
+// Liberar resultado
+void free_compact_result(CompactResult *result) {
+    if (result) {
+        free(result->nodes);
+        free(result);
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef COMPACT_TREE_H
+#define COMPACT_TREE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "xml_tree.h"
+
+#define COMPACT_NONE 0xFFFFFFFFu
+
+// Representación congelada del árbol, construida después del análisis:
+// los nodos se numeran en orden de documento (preorden) y cada campo es un
+// arreglo contiguo (estructura de arreglos) con índices de 32 bits, de modo
+// que un recorrido descendente lee memoria secuencial. Los nombres son los
+// IDs de la tabla de símbolos del documento, que debe seguir vivo
+typedef struct CompactTree {
+    uint32_t node_count;
+    uint8_t *type;              // NodeType
+    uint32_t *name;             // ID del nombre (elementos) o SYMBOL_NONE
+    uint32_t *first_child;
+    uint32_t *next_sibling;
+    uint32_t *parent;
+    uint32_t *span_start;       // Elementos: primer atributo; texto/CDATA: inicio en 'text'
+    uint32_t *span_length;      // Elementos: número de atributos; texto/CDATA: bytes
+
+    // Atributos de todos los elementos, contiguos por elemento
+    uint32_t attr_count;
+    uint32_t *attr_name;
+    uint32_t *attr_value;       // Inicio del valor en 'text'
+
+    // Textos y valores, cada uno terminado en nulo
+    char *text;
+    size_t text_size;
+
+    // Nombres de elementos y atributos (tabla del documento)
+    const SymbolTable *names;
+} CompactTree;
+
+// Resultado de una consulta sobre el árbol compacto (índices de nodos)
+typedef struct CompactResult {
+    uint32_t *nodes;
+    int count;
+    int capacity;
+} CompactResult;
+
+// Construir el árbol compacto a partir del árbol de punteros del documento
+void compact_tree_build(CompactTree *tree, XMLDocument *doc);
+void free_compact_tree(CompactTree *tree);
+
+// Bytes de los arreglos de nodos y atributos (sin textos ni nombres)
+size_t compact_tree_node_memory(CompactTree *tree);
+
+// ID de un nombre o SYMBOL_NONE si no aparece en el documento
+uint32_t compact_name_id(CompactTree *tree, const char *name);
+const char* compact_node_name(CompactTree *tree, uint32_t node);
+const char* compact_node_text(CompactTree *tree, uint32_t node);
+// Primer índice después del subárbol de 'node'
+uint32_t compact_subtree_end(CompactTree *tree, uint32_t node);
+
+// Funciones de resultados
+CompactResult* init_compact_result(void);
+void add_compact_result(CompactResult *result, uint32_t node);
+void free_compact_result(CompactResult *result);
+
+#endif
@@ -2,34 +2,73 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "xml_tree.h"
-#include "semantic_analyzer.h"
 
-extern int yylex();
-extern void yyerror(const char *s);
-extern int yylineno;
-extern FILE *yyin;
-
-XMLNode* root = NULL;
-SemanticTable semantic_table;
-int parse_success = 1;
+// La pila de bison crece en el heap: se admite un anidamiento mucho mayor que
+// el límite por defecto (10000) para documentos profundos
+#define YYMAXDEPTH 10000000
 %}
 
+%code requires {
+#include "xml_parser.h"
+
+// Etiqueta de apertura completa: nombre y atributos
+typedef struct OpenTag {
+    uint32_t name;              // ID en la tabla de símbolos
+    AttributeList *attributes;
+} OpenTag;
+}
+
+%code {
+// Analizador puro: el estado vive en el contexto y en el scanner reentrante
+int yylex(YYSTYPE *yylval_param, void *yyscanner);
+void yyerror(void *scanner, XMLParseContext *ctx, const char *s);
+
+static void release_event_memory(XMLParseContext *ctx);
+
+// Entregar un evento al manejador SAX y detener el análisis si lo pide
+#define SAX_EVENT(callback, ...) \
+    do { \
+        if (ctx->sax->callback && !ctx->sax->callback(ctx->sax_data, __VA_ARGS__)) { \
+            ctx->parse_success = 0; \
+            YYABORT; \
+        } \
+    } while (0)
+
+// Tras un evento, las cadenas y atributos ya entregados no se vuelven a
+// usar; solo se conservan si el parser ya leyó el siguiente token. Los
+// nombres viven en la tabla de símbolos y no se reciclan
+#define RELEASE_EVENT_MEMORY() \
+    do { \
+        if (yychar == YYEMPTY) release_event_memory(ctx); \
+    } while (0)
+}
+
+%define api.pure full
+%define api.push-pull both
+%parse-param {void *scanner} {XMLParseContext *ctx}
+%lex-param {void *scanner}
+
 %union {
     char *str;
+    uint32_t name_id;
     XMLNode *node;
+    NodeList node_list;
     AttributeList *attr_list;
     Attribute *attr;
+    OpenTag open_tag;
 }
 
-%token <str> NAME STRING TEXT CDATA_CONTENT XML_DECL
+%token <name_id> NAME
+%token <str> STRING TEXT CDATA_CONTENT XML_DECL
 %token TAG_START TAG_END END_TAG_START SELF_CLOSING EQUALS
 %token CDATA_START CDATA_END XML_DECL_END
 
-%type <node> document element content_list content
+%type <node> document element content
+%type <node_list> content_list
 %type <attr_list> attribute_list
 %type <attr> attribute
-%type <str> start_tag end_tag
+%type <name_id> start_tag end_tag
+%type <open_tag> open_tag
 
 %start document
 
@@ -37,12 +76,24 @@ int parse_success = 1;
 
 document:
     xml_declaration_opt element {
-        root = $2;
-        if (semantic_analyze(root, &semantic_table)) {
+        ctx->document.root = $2;
+        if (ctx->sax) {
+            // Modo por eventos: sin árbol; el manejador hizo su propio análisis
+        } else if (!ctx->verbose) {
+            if (!semantic_check(ctx->document.root, &ctx->semantic_table)) {
+                ctx->parse_success = 0;
+            }
+        } else if (semantic_analyze(ctx->document.root, &ctx->semantic_table)) {
             printf("Análisis semántico exitoso\n");
         } else {
             printf("Errores en el análisis semántico\n");
-            parse_success = 0;
+            ctx->parse_success = 0;
+        }
+        
+        // Las estadísticas de la tabla guían el planificador de consultas
+        if (!ctx->sax && ctx->parse_success) {
+            ctx->document.statistics = &ctx->semantic_table;
+            ctx->document.statistics_version = ctx->document.version;
         }
     }
     ;
@@ -53,18 +104,39 @@ xml_declaration_opt:
     ;
 
 element:
-    start_tag attribute_list TAG_END content_list end_tag {
-        if (strcmp($1, $5) != 0) {
-            fprintf(stderr, "Error: Tag de apertura '%s' no coincide con tag de cierre '%s'\n", $1, $5);
-            parse_success = 0;
+    open_tag TAG_END content_list end_tag {
+        // Nombres internados: comparar IDs equivale a comparar las cadenas
+        if ($1.name != $4) {
+            fprintf(stderr, "Error: Tag de apertura '%s' no coincide con tag de cierre '%s'\n",
+                    symbol_name(&ctx->document.names, $1.name), symbol_name(&ctx->document.names, $4));
+            ctx->parse_success = 0;
+        }
+        if (ctx->sax) {
+            SAX_EVENT(end_element, symbol_name(&ctx->document.names, $1.name));
+            RELEASE_EVENT_MEMORY();
+            $$ = NULL;
+        } else {
+            $$ = create_element(&ctx->document, $1.name, $1.attributes, $3.first);
+        }
+    }
+    | open_tag SELF_CLOSING {
+        if (ctx->sax) {
+            SAX_EVENT(end_element, symbol_name(&ctx->document.names, $1.name));
+            RELEASE_EVENT_MEMORY();
+            $$ = NULL;
+        } else {
+            $$ = create_element(&ctx->document, $1.name, $1.attributes, NULL);
         }
-        $$ = create_element($1, $2, $4);
-        free($1);
-        free($5);
     }
-    | start_tag attribute_list SELF_CLOSING {
-        $$ = create_element($1, $2, NULL);
-        free($1);
+    ;
+
+open_tag:
+    start_tag attribute_list {
+        $$.name = $1;
+        $$.attributes = $2;
+        if (ctx->sax) {
+            SAX_EVENT(start_element, symbol_name(&ctx->document.names, $1), $1, $2 ? $2->first : NULL);
+        }
     }
     ;
 
@@ -85,19 +157,20 @@ attribute_list:
         $$ = NULL;
     }
     | attribute_list attribute {
-        $$ = add_attribute($1, $2);
+        $$ = add_attribute(&ctx->document, $1, $2);
     }
     ;
 
 attribute:
     NAME EQUALS STRING {
-        $$ = create_attribute($1, $3);
+        $$ = create_attribute(&ctx->document, $1, $3);
     }
     ;
 
 content_list:
     /* empty */ {
-        $$ = NULL;
+        $$.first = NULL;
+        $$.last = NULL;
     }
     | content_list content {
         $$ = add_content($1, $2);
@@ -106,55 +179,104 @@ content_list:
 
 content:
     TEXT {
-        $$ = create_text_node($1);
+        if (ctx->sax) {
+            SAX_EVENT(text, $1);
+            RELEASE_EVENT_MEMORY();
+            $$ = NULL;
+        } else {
+            $$ = create_text_node(&ctx->document, $1);
+        }
     }
     | element {
         $$ = $1;
     }
     | CDATA_START CDATA_CONTENT CDATA_END {
-        $$ = create_cdata_node($2);
+        if (ctx->sax) {
+            SAX_EVENT(cdata, $2);
+            RELEASE_EVENT_MEMORY();
+            $$ = NULL;
+        } else {
+            $$ = create_cdata_node(&ctx->document, $2);
+        }
     }
     ;
 
 %%
 
-int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Uso: %s <archivo.xml>\n", argv[0]);
-        return 1;
+// Inicializar contexto de análisis con las opciones por defecto
+void init_parse_context(XMLParseContext *ctx) {
+    init_xml_document(&ctx->document);
+    init_semantic_table(&ctx->semantic_table);
+    ctx->parse_success = 1;
+    ctx->use_mmap = 1;
+    ctx->fast_path = 1;
+    ctx->verbose = 1;
+    ctx->sax = NULL;
+    ctx->sax_data = NULL;
+    ctx->peak_memory = 0;
+    ctx->input.file = NULL;
+    ctx->input.buffer = NULL;
+    ctx->input.size = 0;
+    ctx->input.mapped_size = 0;
+    ctx->input.mapped = 0;
+    ctx->bytes_read = 0;
+    ctx->input_mapped = 0;
+    ctx->parse_time = 0;
+    ctx->scanner = NULL;
+    ctx->column = 1;
+    ctx->fast_active = 0;
+    ctx->memory_end = NULL;
+}
+
+// Liberar el documento y la tabla semántica del contexto
+void free_parse_context(XMLParseContext *ctx) {
+    free_xml_document(&ctx->document);
+    free_semantic_table(&ctx->semantic_table);
+}
+
+// Reciclar la memoria de los eventos ya entregados y registrar el máximo
+static void release_event_memory(XMLParseContext *ctx) {
+    size_t used = xml_document_memory(&ctx->document);
+    if (used > ctx->peak_memory) {
+        ctx->peak_memory = used;
     }
+    arena_reset(&ctx->document.strings);
+    pool_reset(&ctx->document.attributes);
+    pool_reset(&ctx->document.attribute_lists);
+}
 
-    yyin = fopen(argv[1], "r");
-    if (!yyin) {
-        perror("Error al abrir el archivo");
-        return 1;
+// Analizar ctx->input ya abierta con un scanner y un parser propios del contexto
+int parse_xml_input(XMLParseContext *ctx) {
+    if (!lexer_init(ctx)) {
+        xml_input_close(&ctx->input);
+        return -1;
     }
 
-    init_semantic_table(&semantic_table);
+    double start = xml_time_now();
+    int status = yyparse(ctx->scanner, ctx);
+    ctx->parse_time = xml_time_now() - start;
+    if (xml_document_memory(&ctx->document) > ctx->peak_memory) {
+        ctx->peak_memory = xml_document_memory(&ctx->document);
+    }
 
-    printf("Analizando archivo XML: %s\n", argv[1]);
-    
-    if (yyparse() == 0 && parse_success) {
-        printf("✓ Análisis exitoso del archivo XML\n");
-        printf("✓ Estructura XML válida\n");
-        
-        // Mostrar estadísticas
-        printf("\nEstadísticas del documento:\n");
-        printf("- Elementos: %d\n", count_elements(root));
-        printf("- Atributos: %d\n", count_attributes(root));
-        
-        // Modo interactivo para consultas XPath
-        printf("\nModo consulta XPath (escriba 'quit' para salir):\n");
-        xpath_interactive_mode(root);
-        
-    } else {
-        printf("✗ Error en el análisis del archivo XML\n");
-        return 1;
+    ctx->input_mapped = ctx->input.mapped;
+    if (ctx->input.mapped) {
+        ctx->bytes_read = ctx->input.size;
     }
+    lexer_destroy(ctx);
+    xml_input_close(&ctx->input);
 
-    fclose(yyin);
-    free_xml_tree(root);
-    free_semantic_table(&semantic_table);
-    
-    return 0;
-}
\ No newline at end of file
+    // El árbol terminado se numera para las consultas estructurales
+    if (!ctx->sax && ctx->document.root) {
+        xml_number_nodes(&ctx->document);
+    }
+    return status == 0 && ctx->parse_success;
+}
+
+// Analizar un archivo completo ("-" para stdin)
+int parse_xml_file(XMLParseContext *ctx, const char *path) {
+    if (!xml_input_open(&ctx->input, path, ctx->use_mmap)) {
+        return -1;
+    }
+    return parse_xml_input(ctx);
+}
@@ -0,0 +1,192 @@
+#include "query_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t hash_key(const char *key) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char*)key; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void init_query_cache(QueryCache *cache, size_t max_bytes) {
+    cache->bucket_count = 64;
+    cache->buckets = (QueryCacheEntry**)calloc(cache->bucket_count, sizeof(QueryCacheEntry*));
+    cache->newest = NULL;
+    cache->oldest = NULL;
+    cache->entry_count = 0;
+    cache->bytes = 0;
+    cache->max_bytes = max_bytes;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->evictions = 0;
+    cache->stale = 0;
+}
+
+// Quitar una entrada de la lista LRU y de su cadena, y liberarla
+static void remove_entry(QueryCache *cache, QueryCacheEntry *entry) {
+    if (entry->newer) entry->newer->older = entry->older;
+    else cache->newest = entry->older;
+    if (entry->older) entry->older->newer = entry->newer;
+    else cache->oldest = entry->newer;
+
+    QueryCacheEntry **link = &cache->buckets[entry->hash & (cache->bucket_count - 1)];
+    while (*link != entry) link = &(*link)->chain;
+    *link = entry->chain;
+
+    cache->bytes -= entry->bytes;
+    cache->entry_count--;
+    free(entry->key);
+    free(entry->nodes);
+    free(entry);
+}
+
+// Pasar una entrada al principio de la lista (la más reciente)
+static void touch_entry(QueryCache *cache, QueryCacheEntry *entry) {
+    if (cache->newest == entry) return;
+
+    entry->newer->older = entry->older;
+    if (entry->older) entry->older->newer = entry->newer;
+    else cache->oldest = entry->newer;
+
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    cache->newest->newer = entry;
+    cache->newest = entry;
+}
+
+// Descartar las entradas menos usadas hasta caber en el límite
+static void evict(QueryCache *cache) {
+    while (cache->oldest && cache->bytes > cache->max_bytes) {
+        remove_entry(cache, cache->oldest);
+        cache->evictions++;
+    }
+}
+
+static void grow_buckets(QueryCache *cache) {
+    size_t count = cache->bucket_count * 2;
+    QueryCacheEntry **buckets = (QueryCacheEntry**)calloc(count, sizeof(QueryCacheEntry*));
+    for (QueryCacheEntry *entry = cache->newest; entry; entry = entry->older) {
+        size_t bucket = entry->hash & (count - 1);
+        entry->chain = buckets[bucket];
+        buckets[bucket] = entry;
+    }
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucket_count = count;
+}
+
+void query_cache_clear(QueryCache *cache) {
+    while (cache->oldest) {
+        remove_entry(cache, cache->oldest);
+    }
+}
+
+void free_query_cache(QueryCache *cache) {
+    query_cache_clear(cache);
+    free(cache->buckets);
+    cache->buckets = NULL;
+}
+
+void query_cache_set_limit(QueryCache *cache, size_t max_bytes) {
+    cache->max_bytes = max_bytes;
+    evict(cache);
+}
+
+static XPathResult* copy_result(XMLNode **nodes, int count) {
+    XPathResult *result = init_xpath_result();
+    if (count > 0) {
+        result->nodes = (XMLNode**)malloc(count * sizeof(XMLNode*));
+        memcpy(result->nodes, nodes, count * sizeof(XMLNode*));
+        result->count = count;
+        result->capacity = count;
+    }
+    return result;
+}
+
+// Ejecutar con caché: una entrada de otra versión del documento se descarta
+// y cuenta como fallo
+XPathResult* query_cache_execute(QueryCache *cache, const XPathPlan *plan, XMLDocument *doc) {
+    if (cache->max_bytes == 0) {
+        cache->misses++;
+        return xpath_execute(plan, doc);
+    }
+
+    char *key = xpath_plan_key(plan);
+    uint32_t hash = hash_key(key);
+    QueryCacheEntry *entry = cache->buckets[hash & (cache->bucket_count - 1)];
+    while (entry && (entry->hash != hash || entry->doc_id != doc->id || strcmp(entry->key, key) != 0)) {
+        entry = entry->chain;
+    }
+
+    if (entry && entry->version == doc->version) {
+        cache->hits++;
+        touch_entry(cache, entry);
+        free(key);
+        return copy_result(entry->nodes, entry->count);
+    }
+    if (entry) {
+        remove_entry(cache, entry);
+        cache->stale++;
+    }
+
+    cache->misses++;
+    XPathResult *result = xpath_execute(plan, doc);
+    size_t bytes = sizeof(QueryCacheEntry) + strlen(key) + 1 + result->count * sizeof(XMLNode*);
+    if (bytes > cache->max_bytes) {
+        free(key);
+        return result;
+    }
+
+    entry = (QueryCacheEntry*)malloc(sizeof(QueryCacheEntry));
+    entry->key = key;
+    entry->hash = hash;
+    entry->doc_id = doc->id;
+    entry->version = doc->version;
+    entry->nodes = NULL;
+    entry->count = result->count;
+    entry->bytes = bytes;
+    if (result->count > 0) {
+        entry->nodes = (XMLNode**)malloc(result->count * sizeof(XMLNode*));
+        memcpy(entry->nodes, result->nodes, result->count * sizeof(XMLNode*));
+    }
+
+    if (cache->entry_count >= cache->bucket_count) {
+        grow_buckets(cache);
+    }
+    size_t bucket = hash & (cache->bucket_count - 1);
+    entry->chain = cache->buckets[bucket];
+    cache->buckets[bucket] = entry;
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    if (cache->newest) cache->newest->newer = entry;
+    else cache->oldest = entry;
+    cache->newest = entry;
+    cache->entry_count++;
+    cache->bytes += bytes;
+    evict(cache);
+
+    return result;
+}
+
+XPathResult* query_cache_query(QueryCache *cache, XMLDocument *doc, const char *xpath) {
+    if (!xpath) return init_xpath_result();
+
+    XPathPlan *plan = xpath_compile(xpath);
+    XPathResult *result = query_cache_execute(cache, plan, doc);
+    free_xpath_plan(plan);
+    return result;
+}
+
+void print_query_cache_stats(const QueryCache *cache) {
+    long lookups = cache->hits + cache->misses;
+    printf("Caché de consultas: %zu entrada(s), %zu KB de %zu KB\n",
+           cache->entry_count, cache->bytes / 1024, cache->max_bytes / 1024);
+    printf("  Aciertos: %ld, fallos: %ld (%.1f%% de aciertos)\n", cache->hits, cache->misses,
+           lookups ? cache->hits * 100.0 / lookups : 0.0);
+    printf("  Descartadas: %ld por memoria, %ld por cambios en el documento\n",
+           cache->evictions, cache->stale);
+}
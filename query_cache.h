@@ -0,0 +1,53 @@
+#ifndef QUERY_CACHE_H
+#define QUERY_CACHE_H
+
+#include <stddef.h>
+#include "xpath_engine.h"
+
+#define QUERY_CACHE_DEFAULT_BYTES (16 * 1024 * 1024)
+
+// Resultado guardado de una consulta sobre una versión de un documento
+typedef struct QueryCacheEntry {
+    char *key;                      // Forma normalizada (xpath_plan_key)
+    uint32_t hash;
+    unsigned long doc_id;           // XMLDocument.id
+    unsigned long version;          // XMLDocument.version al ejecutarla
+    XMLNode **nodes;
+    int count;
+    size_t bytes;                   // Memoria de la entrada
+    struct QueryCacheEntry *newer;  // Lista LRU
+    struct QueryCacheEntry *older;
+    struct QueryCacheEntry *chain;  // Cadena de la tabla hash
+} QueryCacheEntry;
+
+// Caché LRU de resultados: la clave es la expresión normalizada y una
+// entrada solo vale para el documento (por su id, no por su dirección) y la
+// versión con que se ejecutó. Si la memoria pasa de max_bytes se descartan
+// las menos usadas
+typedef struct QueryCache {
+    QueryCacheEntry **buckets;
+    size_t bucket_count;
+    QueryCacheEntry *newest;
+    QueryCacheEntry *oldest;
+    size_t entry_count;
+    size_t bytes;
+    size_t max_bytes;               // 0 = desactivada
+    long hits;
+    long misses;
+    long evictions;
+    long stale;                     // Entradas descartadas por cambios en el documento
+} QueryCache;
+
+void init_query_cache(QueryCache *cache, size_t max_bytes);
+void free_query_cache(QueryCache *cache);
+void query_cache_clear(QueryCache *cache);
+void query_cache_set_limit(QueryCache *cache, size_t max_bytes);
+
+// Ejecutar un plan (o una expresión) a través de la caché; el resultado es
+// una copia que se libera con free_xpath_result, como el de xpath_execute
+XPathResult* query_cache_execute(QueryCache *cache, const XPathPlan *plan, XMLDocument *doc);
+XPathResult* query_cache_query(QueryCache *cache, XMLDocument *doc, const char *xpath);
+
+void print_query_cache_stats(const QueryCache *cache);
+
+#endif
@@ -0,0 +1,628 @@
+#include "query_set.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Nodo del contexto en el recorrido: sus estados y el hijo que toca visitar
+typedef struct SetFrame {
+    XMLNode *child;             // Próximo hijo por visitar
+    int active;                 // Inicio de sus estados en SetRun.active
+    int active_count;
+    int inherited;              // Longitud de SetRun.inherited antes del nodo
+    int positions;              // Posiciones de sus hijos en SetRun.positions (-1 = no hacen falta)
+    int ordinal;                // Elementos hijos ya visitados
+} SetFrame;
+
+// Posición de un elemento entre sus hermanos con su nombre y entre todos
+typedef struct SiblingPosition {
+    int by_name;
+    int any;
+    unsigned char last_by_name;
+    unsigned char last_any;
+} SiblingPosition;
+
+// Estado de una ejecución: las pilas del recorrido y la traducción de nombres
+typedef struct SetRun {
+    const QuerySet *set;
+    XPathResult **results;
+    uint32_t *from_doc;         // ID del documento -> ID del conjunto
+    uint32_t doc_names;
+    uint32_t *to_doc;           // ID del conjunto -> ID del documento
+    SetFrame *frames;
+    int depth;
+    int frame_capacity;
+    int *active;                // Estados alcanzados por cada nodo de la pila
+    int active_count;
+    int active_capacity;
+    int *inherited;             // Estados de ancestros con transiciones por '//'
+    int inherited_count;
+    int inherited_positions;    // De ellos, cuántos tienen [n] o [last()]
+    int *references;            // Veces que cada estado está en la pila de ancestros
+    SiblingPosition *positions;
+    int position_count;
+    int position_capacity;
+    int *sibling_counts;        // Hermanos por nombre (a cero entre usos)
+    int visit;                  // Número del elemento que se está visitando
+    int *chain_visits;          // Último elemento con el que se siguió cada cadena
+    int *transition_visits;     // Último elemento que cumplió cada transición de [@a='v'] o contains()
+    int needles;                // ¿Hay que buscar trigramas en el texto del elemento?
+} SetRun;
+
+static uint32_t hash_chain(int state, XPathAxis axis, uint32_t name) {
+    uint32_t hash = (uint32_t)state * 2654435761u;
+    hash ^= name * 2246822519u + (uint32_t)axis;
+    return hash ^ (hash >> 15);
+}
+
+static uint32_t hash_value(int chain, uint32_t attr, const char *value) {
+    uint32_t hash = 2166136261u ^ ((uint32_t)chain * 2654435761u) ^ attr;
+    for (const unsigned char *p = (const unsigned char*)value; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t trigram_key(const char *p) {
+    const unsigned char *bytes = (const unsigned char*)p;
+    return (uint32_t)bytes[0] << 16 | (uint32_t)bytes[1] << 8 | bytes[2];
+}
+
+// Cadena de (estado, eje, nombre) o -1 si no hay; 'slot' recibe su posición
+// en la tabla o la libre donde iría
+static int find_chain(const QuerySet *set, int state, XPathAxis axis, uint32_t name, uint32_t *slot) {
+    uint32_t mask = set->chain_slot_count - 1;
+    uint32_t i = hash_chain(state, axis, name) & mask;
+    while (set->chain_slots[i]) {
+        const QuerySetChain *chain = &set->chains[set->chain_slots[i] - 1];
+        if (chain->state == state && chain->axis == axis && chain->name == name) break;
+        i = (i + 1) & mask;
+    }
+    if (slot) *slot = i;
+    return (int)set->chain_slots[i] - 1;
+}
+
+static void grow_chain_slots(QuerySet *set) {
+    free(set->chain_slots);
+    set->chain_slot_count = set->chain_slot_count ? set->chain_slot_count * 2 : 64;
+    set->chain_slots = (uint32_t*)calloc(set->chain_slot_count, sizeof(uint32_t));
+    for (int i = 0; i < set->chain_count; i++) {
+        const QuerySetChain *chain = &set->chains[i];
+        if (chain->name == SYMBOL_NONE) continue;
+        uint32_t slot;
+        find_chain(set, chain->state, chain->axis, chain->name, &slot);
+        set->chain_slots[slot] = (uint32_t)i + 1;
+    }
+}
+
+// Transición de [@a='v'] de una cadena: su posición en la tabla de valores
+// o la libre donde iría
+static int find_value(const QuerySet *set, int chain, uint32_t attr, const char *value, uint32_t hash) {
+    int mask = set->value_slot_count - 1;
+    int i = (int)(hash & (uint32_t)mask);
+    while (set->values[i].chain >= 0) {
+        const QuerySetValue *entry = &set->values[i];
+        if (entry->hash == hash && entry->chain == chain && entry->attr_name == attr &&
+            strcmp(entry->value, value) == 0) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static void grow_values(QuerySet *set) {
+    QuerySetValue *old = set->values;
+    int old_count = set->value_slot_count;
+
+    set->value_slot_count = old_count ? old_count * 2 : 64;
+    set->values = (QuerySetValue*)malloc(set->value_slot_count * sizeof(QuerySetValue));
+    for (int i = 0; i < set->value_slot_count; i++) {
+        set->values[i].chain = -1;
+    }
+    for (int i = 0; i < old_count; i++) {
+        if (old[i].chain < 0) continue;
+        set->values[find_value(set, old[i].chain, old[i].attr_name, old[i].value, old[i].hash)] = old[i];
+    }
+    free(old);
+}
+
+static QuerySetTrigram* find_trigram(const QuerySet *set, uint32_t key) {
+    uint32_t mask = set->trigram_slot_count - 1;
+    uint32_t hash = key * 2654435761u;
+    uint32_t i = (hash ^ (hash >> 16)) & mask;
+    while (set->trigrams[i].key != 0 && set->trigrams[i].key != key) {
+        i = (i + 1) & mask;
+    }
+    return &set->trigrams[i];
+}
+
+static void grow_trigrams(QuerySet *set) {
+    QuerySetTrigram *old = set->trigrams;
+    int old_count = set->trigram_slot_count;
+
+    set->trigram_slot_count = old_count ? old_count * 2 : 64;
+    set->trigrams = (QuerySetTrigram*)calloc(set->trigram_slot_count, sizeof(QuerySetTrigram));
+    for (int i = 0; i < old_count; i++) {
+        if (old[i].key != 0) *find_trigram(set, old[i].key) = old[i];
+    }
+    free(old);
+}
+
+static int add_state(QuerySet *set) {
+    if (set->state_count >= set->state_capacity) {
+        set->state_capacity = set->state_capacity ? set->state_capacity * 2 : 16;
+        set->states = (QuerySetState*)realloc(set->states, set->state_capacity * sizeof(QuerySetState));
+    }
+    QuerySetState *state = &set->states[set->state_count];
+    state->accepts = NULL;
+    state->accept_count = 0;
+    state->children = 0;
+    state->descendants = 0;
+    state->any_children = -1;
+    state->any_descendants = -1;
+    state->positions = 0;
+    return set->state_count++;
+}
+
+// Cadena de (estado, eje, nombre), creándola si no existe. Las de '*' se
+// guardan en el estado y no en la tabla
+static int get_chain(QuerySet *set, int state, XPathAxis axis, uint32_t name) {
+    int *any = axis == AXIS_CHILD ? &set->states[state].any_children : &set->states[state].any_descendants;
+    uint32_t slot = 0;
+    int found = -1;
+    if (name == SYMBOL_NONE) {
+        found = *any;
+    } else {
+        if ((set->chain_count + 1) * 2 > set->chain_slot_count) grow_chain_slots(set);
+        found = find_chain(set, state, axis, name, &slot);
+    }
+    if (found >= 0) return found;
+
+    if (set->chain_count >= set->chain_capacity) {
+        set->chain_capacity = set->chain_capacity ? set->chain_capacity * 2 : 16;
+        set->chains = (QuerySetChain*)realloc(set->chains, set->chain_capacity * sizeof(QuerySetChain));
+    }
+    QuerySetChain *chain = &set->chains[set->chain_count];
+    chain->state = state;
+    chain->axis = axis;
+    chain->name = name;
+    chain->first = -1;
+    chain->values = 0;
+    chain->needles = 0;
+    if (name == SYMBOL_NONE) *any = set->chain_count;
+    else set->chain_slots[slot] = (uint32_t)set->chain_count + 1;
+    return set->chain_count++;
+}
+
+// Nombre de un plan en la tabla del conjunto
+static uint32_t set_name(QuerySet *set, const XPathPlan *plan, uint32_t id) {
+    if (id == SYMBOL_NONE) return SYMBOL_NONE;
+    const char *name = plan->names.names[id];
+    return symbol_intern(&set->names, name, strlen(name));
+}
+
+static int same_string(const char *a, const char *b) {
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+// ¿Es la transición el mismo paso (mismo predicado)? El eje y el nombre ya
+// coinciden por la cadena
+static int same_step(const QuerySetTransition *transition, const XPathPlanStep *step, uint32_t attr) {
+    const XPathPlanStep *other = transition->step;
+    return other->kind == step->kind && transition->attr_name == attr && other->position == step->position &&
+           same_string(other->attr_value, step->attr_value) && same_string(other->search, step->search);
+}
+
+// ¿Se busca el texto del paso por su primer trigrama?
+static int step_needle(const XPathPlanStep *step) {
+    return (step->kind == STEP_CONTAINS || step->kind == STEP_TOKEN) && strlen(step->search) >= 3;
+}
+
+// Estado al que lleva un paso desde 'from', creándolo si ningún plan
+// anterior tenía ese mismo paso tras el mismo prefijo
+static int follow_step(QuerySet *set, int from, const XPathPlan *plan, const XPathPlanStep *step) {
+    uint32_t name = step->any_name ? SYMBOL_NONE : set_name(set, plan, step->name);
+    uint32_t attr = set_name(set, plan, step->attr_name);
+    int chain = get_chain(set, from, step->axis, name);
+    int by_value = step->kind == STEP_ATTRIBUTE && step->attr_value;
+    int needle = step_needle(step);
+
+    // ¿Ya existe la transición?
+    int value_slot = -1;
+    uint32_t hash = 0;
+    QuerySetTrigram *trigram = NULL;
+    int first;
+    if (by_value) {
+        if ((set->value_count + 1) * 2 > set->value_slot_count) grow_values(set);
+        hash = hash_value(chain, attr, step->attr_value);
+        value_slot = find_value(set, chain, attr, step->attr_value, hash);
+        first = set->values[value_slot].chain >= 0 ? set->values[value_slot].transition : -1;
+    } else if (needle) {
+        if ((set->trigram_count + 1) * 2 > set->trigram_slot_count) grow_trigrams(set);
+        trigram = find_trigram(set, trigram_key(step->search));
+        first = trigram->key ? trigram->first : -1;
+    } else {
+        first = set->chains[chain].first;
+    }
+    for (int i = first; i >= 0; i = set->transitions[i].next) {
+        if (set->transitions[i].chain == chain && same_step(&set->transitions[i], step, attr)) {
+            return set->transitions[i].target;
+        }
+        if (by_value) break;
+    }
+
+    int target = add_state(set);
+    if (set->transition_count >= set->transition_capacity) {
+        set->transition_capacity = set->transition_capacity ? set->transition_capacity * 2 : 16;
+        set->transitions = (QuerySetTransition*)realloc(set->transitions,
+                                                        set->transition_capacity * sizeof(QuerySetTransition));
+    }
+    int index = set->transition_count++;
+    QuerySetTransition *transition = &set->transitions[index];
+    transition->step = step;
+    transition->chain = chain;
+    transition->attr_name = attr;
+    transition->target = target;
+    transition->next = -1;
+
+    if (by_value) {
+        QuerySetValue *entry = &set->values[value_slot];
+        entry->chain = chain;
+        entry->attr_name = attr;
+        entry->hash = hash;
+        entry->value = step->attr_value;
+        entry->transition = index;
+        set->value_count++;
+        set->chains[chain].values++;
+    } else if (needle) {
+        if (!trigram->key) {
+            trigram->key = trigram_key(step->search);
+            trigram->first = -1;
+            set->trigram_count++;
+        }
+        transition->next = trigram->first;
+        trigram->first = index;
+        set->chains[chain].needles++;
+    } else {
+        transition->next = set->chains[chain].first;
+        set->chains[chain].first = index;
+    }
+
+    QuerySetState *state = &set->states[from];
+    if (step->axis == AXIS_CHILD) state->children++;
+    else state->descendants++;
+    if (step->kind == STEP_POSITION) state->positions++;
+    return target;
+}
+
+// Combinar los planes en el autómata: cada consulta es un camino desde el
+// estado 0 y termina en el estado que la acepta. Las consultas sin pasos o
+// con un predicado sin cerrar no tienen estado y su resultado queda vacío
+QuerySet* query_set_compile(XPathPlan **plans, int count) {
+    QuerySet *set = (QuerySet*)calloc(1, sizeof(QuerySet));
+    set->plans = plans;
+    set->plan_count = count;
+    init_symbol_table(&set->names);
+    grow_chain_slots(set);
+    grow_values(set);
+    grow_trigrams(set);
+    add_state(set);
+
+    for (int q = 0; q < count; q++) {
+        const XPathPlan *plan = plans[q];
+        int valid = plan->step_count > 0;
+        for (int i = 0; i < plan->step_count; i++) {
+            const XPathPlanStep *step = &plan->steps[i];
+            if (step->kind == STEP_INVALID || (!step->any_name && step->name == SYMBOL_NONE)) valid = 0;
+        }
+        if (!valid) continue;
+
+        int state = 0;
+        for (int i = 0; i < plan->step_count; i++) {
+            state = follow_step(set, state, plan, &plan->steps[i]);
+        }
+        QuerySetState *accept = &set->states[state];
+        accept->accepts = (int*)realloc(accept->accepts, (accept->accept_count + 1) * sizeof(int));
+        accept->accepts[accept->accept_count++] = q;
+    }
+    return set;
+}
+
+void free_query_set(QuerySet *set) {
+    if (!set) return;
+    for (int i = 0; i < set->state_count; i++) {
+        free(set->states[i].accepts);
+    }
+    free(set->states);
+    free(set->transitions);
+    free(set->chains);
+    free(set->chain_slots);
+    free(set->values);
+    free(set->trigrams);
+    free_symbol_table(&set->names);
+    free(set);
+}
+
+// Posiciones de los elementos de una lista de hermanos, para [n] y [last()]
+static int compute_positions(SetRun *run, XMLNode *first) {
+    int start = run->position_count;
+    int any = 0;
+    for (XMLNode *child = first; child; child = child->next) {
+        if (child->type != NODE_ELEMENT) continue;
+        if (run->position_count >= run->position_capacity) {
+            run->position_capacity = run->position_capacity ? run->position_capacity * 2 : 64;
+            run->positions = (SiblingPosition*)realloc(run->positions,
+                                                       run->position_capacity * sizeof(SiblingPosition));
+        }
+        SiblingPosition *position = &run->positions[run->position_count++];
+        position->by_name = ++run->sibling_counts[child->name_id];
+        position->any = ++any;
+    }
+
+    int i = start;
+    for (XMLNode *child = first; child; child = child->next) {
+        if (child->type != NODE_ELEMENT) continue;
+        SiblingPosition *position = &run->positions[i++];
+        position->last_by_name = position->by_name == run->sibling_counts[child->name_id];
+        position->last_any = position->any == any;
+    }
+    for (XMLNode *child = first; child; child = child->next) {
+        if (child->type == NODE_ELEMENT) run->sibling_counts[child->name_id] = 0;
+    }
+    return start;
+}
+
+// ¿Cumple el elemento el predicado de la transición? El nombre ya coincide
+static int transition_matches(const SetRun *run, const QuerySetTransition *transition, XMLNode *node,
+                              const SiblingPosition *position) {
+    const XPathPlanStep *step = transition->step;
+    int any_name = run->set->chains[transition->chain].name == SYMBOL_NONE;
+    switch (step->kind) {
+        case STEP_ATTRIBUTE: {
+            uint32_t attr_id = run->to_doc[transition->attr_name];
+            if (!node->attributes) return 0;
+            for (Attribute *attr = node->attributes->first; attr; attr = attr->next) {
+                if (attr->name_id == attr_id && (!step->attr_value || strcmp(attr->value, step->attr_value) == 0)) {
+                    return 1;
+                }
+            }
+            return 0;
+        }
+        case STEP_CONTAINS:
+        case STEP_TOKEN:
+            for (XMLNode *child = node->children; child; child = child->next) {
+                if ((child->type == NODE_TEXT || child->type == NODE_CDATA) && child->content &&
+                    xml_text_contains(child->content, step->search, step->kind == STEP_TOKEN)) {
+                    return 1;
+                }
+            }
+            return 0;
+        case STEP_POSITION:
+            if (step->position == XPATH_POSITION_LAST) {
+                return any_name ? position->last_any : position->last_by_name;
+            }
+            return (any_name ? position->any : position->by_name) == step->position;
+        default:
+            return 1;
+    }
+}
+
+// El elemento cumple la transición: su estado se apila y las consultas que
+// acepta reciben el nodo
+static void take_transition(SetRun *run, const QuerySetTransition *transition, XMLNode *node) {
+    if (run->active_count >= run->active_capacity) {
+        run->active_capacity *= 2;
+        run->active = (int*)realloc(run->active, run->active_capacity * sizeof(int));
+    }
+    run->active[run->active_count++] = transition->target;
+    const QuerySetState *state = &run->set->states[transition->target];
+    for (int j = 0; j < state->accept_count; j++) {
+        add_to_result(run->results[state->accepts[j]], node);
+    }
+}
+
+// Seguir una cadena con el elemento: su lista se comprueba transición a
+// transición, los [@a='v'] se buscan por cada atributo del elemento y los
+// contains() quedan marcados para la búsqueda por trigramas
+static void follow_chain(SetRun *run, int index, XMLNode *node, const SiblingPosition *position) {
+    const QuerySet *set = run->set;
+    const QuerySetChain *chain = &set->chains[index];
+    for (int i = chain->first; i >= 0; i = set->transitions[i].next) {
+        if (transition_matches(run, &set->transitions[i], node, position)) {
+            take_transition(run, &set->transitions[i], node);
+        }
+    }
+
+    if (chain->values > 0 && node->attributes) {
+        for (Attribute *attr = node->attributes->first; attr; attr = attr->next) {
+            uint32_t name = attr->name_id < run->doc_names ? run->from_doc[attr->name_id] : SYMBOL_NONE;
+            if (name == SYMBOL_NONE) continue;
+            const QuerySetValue *value = &set->values[find_value(set, index, name, attr->value,
+                                                                 hash_value(index, name, attr->value))];
+
+            // Un atributo repetido no vuelve a tomar la transición
+            if (value->chain >= 0 && run->transition_visits[value->transition] != run->visit) {
+                run->transition_visits[value->transition] = run->visit;
+                take_transition(run, &set->transitions[value->transition], node);
+            }
+        }
+    }
+
+    if (chain->needles > 0) {
+        run->chain_visits[index] = run->visit;
+        run->needles = 1;
+    }
+}
+
+// contains() de las cadenas seguidas con el elemento: cada posición de sus
+// textos busca por su trigrama los textos buscados que empiezan así
+static void match_needles(SetRun *run, XMLNode *node) {
+    const QuerySet *set = run->set;
+    for (XMLNode *child = node->children; child; child = child->next) {
+        if ((child->type != NODE_TEXT && child->type != NODE_CDATA) || !child->content) continue;
+
+        const char *text = child->content;
+        for (const char *p = text; p[0] && p[1] && p[2]; p++) {
+            QuerySetTrigram *trigram = find_trigram(set, trigram_key(p));
+            if (!trigram->key) continue;
+            for (int i = trigram->first; i >= 0; i = set->transitions[i].next) {
+                const QuerySetTransition *transition = &set->transitions[i];
+                const XPathPlanStep *step = transition->step;
+                if (run->chain_visits[transition->chain] != run->visit ||
+                    run->transition_visits[i] == run->visit) {
+                    continue;
+                }
+                size_t length = strlen(step->search);
+                if (strncmp(p, step->search, length) == 0 &&
+                    xml_text_match_at(text, p, length, step->kind == STEP_TOKEN)) {
+                    run->transition_visits[i] = run->visit;
+                    take_transition(run, transition, node);
+                }
+            }
+        }
+    }
+}
+
+// Apilar un nodo del contexto con los estados active[start..active_count):
+// los que tienen transiciones por '//' valen para todos sus descendientes
+static void push_frame(SetRun *run, XMLNode *first_child, int start) {
+    const QuerySet *set = run->set;
+    if (run->depth >= run->frame_capacity) {
+        run->frame_capacity *= 2;
+        run->frames = (SetFrame*)realloc(run->frames, run->frame_capacity * sizeof(SetFrame));
+    }
+    SetFrame *frame = &run->frames[run->depth++];
+    frame->child = first_child;
+    frame->active = start;
+    frame->active_count = run->active_count - start;
+    frame->inherited = run->inherited_count;
+    frame->positions = -1;
+    frame->ordinal = 0;
+
+    int positions = run->inherited_positions > 0;
+    for (int i = start; i < run->active_count; i++) {
+        int id = run->active[i];
+        const QuerySetState *state = &set->states[id];
+        if (state->positions > 0) positions = 1;
+        if (state->descendants > 0 && run->references[id]++ == 0) {
+            run->inherited[run->inherited_count++] = id;
+            if (state->positions > 0) run->inherited_positions++;
+        }
+    }
+    if (positions) {
+        frame->positions = compute_positions(run, first_child);
+    }
+}
+
+static void pop_frame(SetRun *run) {
+    const QuerySet *set = run->set;
+    SetFrame *frame = &run->frames[--run->depth];
+    for (int i = frame->active; i < frame->active + frame->active_count; i++) {
+        if (set->states[run->active[i]].descendants > 0) run->references[run->active[i]]--;
+    }
+    for (int i = frame->inherited; i < run->inherited_count; i++) {
+        if (set->states[run->inherited[i]].positions > 0) run->inherited_positions--;
+    }
+    run->inherited_count = frame->inherited;
+    run->active_count = frame->active;
+    if (frame->positions >= 0) run->position_count = frame->positions;
+}
+
+// Recorrido en preorden con una pila de nodos de contexto. Para cada elemento
+// se siguen las transiciones por hijos de los estados de su padre y las de
+// descendientes de los estados de sus ancestros; solo se baja a sus hijos si
+// desde los estados alcanzados (o los de los ancestros) se puede avanzar
+void query_set_execute(const QuerySet *set, XMLDocument *doc, XPathResult **results) {
+    for (int q = 0; q < set->plan_count; q++) {
+        results[q] = init_xpath_result();
+    }
+    if (!doc->root) return;
+
+    SetRun run;
+    memset(&run, 0, sizeof(SetRun));
+    run.set = set;
+    run.results = results;
+    run.doc_names = doc->names.count;
+    run.from_doc = (uint32_t*)malloc((run.doc_names ? run.doc_names : 1) * sizeof(uint32_t));
+    for (uint32_t id = 0; id < run.doc_names; id++) {
+        run.from_doc[id] = SYMBOL_NONE;
+    }
+    run.to_doc = (uint32_t*)malloc((set->names.count ? set->names.count : 1) * sizeof(uint32_t));
+    for (uint32_t id = 0; id < set->names.count; id++) {
+        run.to_doc[id] = symbol_lookup(&doc->names, set->names.names[id]);
+        if (run.to_doc[id] != SYMBOL_NONE) run.from_doc[run.to_doc[id]] = id;
+    }
+    run.frame_capacity = 64;
+    run.frames = (SetFrame*)malloc(run.frame_capacity * sizeof(SetFrame));
+    run.active_capacity = 64;
+    run.active = (int*)malloc(run.active_capacity * sizeof(int));
+    run.inherited = (int*)malloc(set->state_count * sizeof(int));
+    run.references = (int*)calloc(set->state_count, sizeof(int));
+    run.sibling_counts = (int*)calloc(run.doc_names ? run.doc_names : 1, sizeof(int));
+    run.chain_visits = (int*)calloc(set->chain_count ? set->chain_count : 1, sizeof(int));
+    run.transition_visits = (int*)calloc(set->transition_count ? set->transition_count : 1, sizeof(int));
+
+    // El documento es el primer contexto, en el estado 0
+    run.active[run.active_count++] = 0;
+    push_frame(&run, doc->root, 0);
+
+    while (run.depth > 0) {
+        SetFrame *frame = &run.frames[run.depth - 1];
+        XMLNode *node = frame->child;
+        if (!node) {
+            pop_frame(&run);
+            continue;
+        }
+        frame->child = node->next;
+        if (node->type != NODE_ELEMENT) continue;
+
+        const SiblingPosition *position = frame->positions >= 0 ? &run.positions[frame->positions + frame->ordinal]
+                                                                : NULL;
+        frame->ordinal++;
+        uint32_t name = node->name_id < run.doc_names ? run.from_doc[node->name_id] : SYMBOL_NONE;
+        int start = run.active_count;
+        run.visit++;
+        run.needles = 0;
+
+        for (int i = frame->active; i < frame->active + frame->active_count; i++) {
+            const QuerySetState *state = &set->states[run.active[i]];
+            if (state->children == 0) continue;
+            int chain = name != SYMBOL_NONE ? find_chain(set, run.active[i], AXIS_CHILD, name, NULL) : -1;
+            if (chain >= 0) follow_chain(&run, chain, node, position);
+            if (state->any_children >= 0) follow_chain(&run, state->any_children, node, position);
+        }
+        for (int i = 0; i < run.inherited_count; i++) {
+            const QuerySetState *state = &set->states[run.inherited[i]];
+            int chain = name != SYMBOL_NONE ? find_chain(set, run.inherited[i], AXIS_DESCENDANT, name, NULL) : -1;
+            if (chain >= 0) follow_chain(&run, chain, node, position);
+            if (state->any_descendants >= 0) follow_chain(&run, state->any_descendants, node, position);
+        }
+        if (run.needles) {
+            match_needles(&run, node);
+        }
+
+        // Bajar solo si algún estado puede seguir avanzando por los hijos
+        int descend = run.inherited_count > 0;
+        for (int i = start; i < run.active_count && !descend; i++) {
+            const QuerySetState *state = &set->states[run.active[i]];
+            descend = state->children > 0 || state->descendants > 0;
+        }
+        if (descend && node->children) {
+            push_frame(&run, node->children, start);
+        } else {
+            run.active_count = start;
+        }
+    }
+
+    free(run.from_doc);
+    free(run.to_doc);
+    free(run.frames);
+    free(run.active);
+    free(run.inherited);
+    free(run.references);
+    free(run.positions);
+    free(run.sibling_counts);
+    free(run.chain_visits);
+    free(run.transition_visits);
+}
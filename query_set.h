@@ -0,0 +1,93 @@
+#ifndef QUERY_SET_H
+#define QUERY_SET_H
+
+#include "xpath_engine.h"
+
+// Transición del autómata: un paso de una o más consultas
+typedef struct QuerySetTransition {
+    const XPathPlanStep *step;  // Paso del primer plan que la creó (predicado)
+    int chain;                  // Cadena a la que pertenece
+    uint32_t attr_name;         // Atributo del predicado en la tabla del conjunto
+    int target;                 // Estado al que lleva
+    int next;                   // Siguiente de su lista (-1 = fin)
+} QuerySetTransition;
+
+// Transiciones que salen de un estado con un eje y un nombre. Las de
+// [@a='v'] no están en la lista sino en la tabla de valores, y las de
+// contains() con tres bytes o más, en la de trigramas
+typedef struct QuerySetChain {
+    int state;
+    XPathAxis axis;
+    uint32_t name;              // SYMBOL_NONE = '*'
+    int first;                  // Resto de transiciones (-1 = ninguna)
+    int values;                 // Transiciones en la tabla de valores
+    int needles;                // Transiciones en la tabla de trigramas
+} QuerySetChain;
+
+// Estado: un prefijo de pasos común a varias consultas
+typedef struct QuerySetState {
+    int *accepts;               // Consultas que terminan aquí
+    int accept_count;
+    int children;               // Transiciones por el eje de hijos
+    int descendants;            // Transiciones por el eje de descendientes
+    int any_children;           // Cadena de '*' por hijos (-1 = ninguna)
+    int any_descendants;        // Cadena de '*' por descendientes (-1 = ninguna)
+    int positions;              // Transiciones con [n] o [last()]
+} QuerySetState;
+
+// Transición de [@a='v'] por cadena, atributo y valor
+typedef struct QuerySetValue {
+    int chain;                  // -1 = libre
+    uint32_t attr_name;
+    uint32_t hash;
+    const char *value;
+    int transition;
+} QuerySetValue;
+
+// Transiciones de contains() por el primer trigrama del texto buscado
+typedef struct QuerySetTrigram {
+    uint32_t key;               // 0 = libre
+    int first;
+} QuerySetTrigram;
+
+// Conjunto de consultas que se evalúan juntas en un solo recorrido del
+// documento: los planes se combinan en un autómata sobre los caminos de
+// elementos en el que los pasos comunes de varias consultas (mismo eje,
+// nombre y predicado tras el mismo prefijo) son un único estado. Es
+// inmutable, como los planes, que deben vivir más que el conjunto
+typedef struct QuerySet {
+    XPathPlan **plans;
+    int plan_count;
+    QuerySetState *states;      // El estado 0 es el documento
+    int state_count;
+    int state_capacity;
+    QuerySetTransition *transitions;
+    int transition_count;
+    int transition_capacity;
+    QuerySetChain *chains;
+    int chain_count;
+    int chain_capacity;
+    uint32_t *chain_slots;      // Tabla hash abierta (estado, eje, nombre): cadena + 1 (0 = libre)
+    int chain_slot_count;
+    QuerySetValue *values;      // Tabla hash abierta (cadena, atributo, valor)
+    int value_count;
+    int value_slot_count;
+    QuerySetTrigram *trigrams;  // Tabla hash abierta por trigrama
+    int trigram_count;
+    int trigram_slot_count;
+    SymbolTable names;          // Nombres de elementos y atributos de las consultas
+} QuerySet;
+
+QuerySet* query_set_compile(XPathPlan **plans, int count);
+void free_query_set(QuerySet *set);
+
+// Ejecutar todas las consultas del conjunto con un recorrido en preorden del
+// documento: 'results' recibe plan_count resultados, uno por consulta y en el
+// orden de los planes, iguales a los de xpath_execute (orden de documento y
+// sin duplicados). Los subárboles en los que ninguna consulta puede avanzar no
+// se visitan, y los predicados [@a='v'] y contains() de muchas consultas se
+// resuelven con una búsqueda por atributo o por posición del texto en lugar
+// de comprobarse uno a uno. Cada resultado se libera con free_xpath_result
+void query_set_execute(const QuerySet *set, XMLDocument *doc, XPathResult **results);
+
+#endif
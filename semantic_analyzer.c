@@ -1,3 +1,4 @@
+#define _GNU_SOURCE  // strdup con -std=c99
 #include "semantic_analyzer.h"
 #include <ctype.h>
 
@@ -8,6 +9,8 @@ void init_semantic_table(SemanticTable *table) {
     table->total_attributes = 0;
     table->has_root = false;
     table->root_name = NULL;
+    table->entries_by_id = NULL;
+    table->entries_by_id_size = 0;
 }
 
 // Liberar memoria de la tabla semántica
@@ -21,6 +24,10 @@ void free_semantic_table(SemanticTable *table) {
             free(current->attribute_names[i]);
         }
         free(current->attribute_names);
+        free(current->attribute_ids);
+        free(current->attribute_counts);
+        free(current->attribute_seen);
+        free(current->attribute_values);
         free(current);
         current = next;
     }
@@ -28,69 +35,86 @@ void free_semantic_table(SemanticTable *table) {
     if (table->root_name) {
         free(table->root_name);
     }
+    free(table->entries_by_id);
 }
 
-// Validar que los nombres de elementos sean válidos
-bool validate_element_names(XMLNode *node) {
-    if (!node) return true;
+// Validar un nombre de elemento o atributo ('kind' = "elemento"/"atributo")
+static bool check_name(const char *name, const char *kind) {
+    if (!name || strlen(name) == 0) {
+        printf("Error semántico: %c%s sin nombre\n", toupper(kind[0]), kind + 1);
+        return false;
+    }
     
-    if (node->type == NODE_ELEMENT) {
-        if (!node->name || strlen(node->name) == 0) {
-            printf("Error semántico: Elemento sin nombre\n");
-            return false;
-        }
-        
-        // Verificar que el nombre comience con letra o underscore
-        if (!isalpha(node->name[0]) && node->name[0] != '_') {
-            printf("Error semántico: Nombre de elemento '%s' inválido\n", node->name);
+    // Verificar que el nombre comience con letra o underscore
+    if (!isalpha(name[0]) && name[0] != '_') {
+        printf("Error semántico: Nombre de %s '%s' inválido\n", kind, name);
+        return false;
+    }
+    
+    // Verificar que contenga solo caracteres válidos
+    for (int i = 1; name[i]; i++) {
+        if (!isalnum(name[i]) && name[i] != '_' && 
+            name[i] != '-' && name[i] != '.') {
+            printf("Error semántico: Nombre de %s '%s' contiene caracteres inválidos\n", kind, name);
             return false;
         }
-        
-        // Verificar que contenga solo caracteres válidos
-        for (int i = 1; i < strlen(node->name); i++) {
-            if (!isalnum(node->name[i]) && node->name[i] != '_' && 
-                node->name[i] != '-' && node->name[i] != '.') {
-                printf("Error semántico: Nombre de elemento '%s' contiene caracteres inválidos\n", node->name);
-                return false;
-            }
+    }
+    return true;
+}
+
+// Marcar un ID de nombre como validado; devuelve true si ya lo estaba.
+// Los nombres internados son iguales si y solo si sus IDs lo son
+static bool mark_checked(uint8_t **checked, uint32_t *size, uint32_t id) {
+    if (id >= *size) {
+        uint32_t new_size = *size ? *size : 64;
+        while (new_size <= id) new_size *= 2;
+        *checked = (uint8_t*)realloc(*checked, new_size);
+        memset(*checked + *size, 0, new_size - *size);
+        *size = new_size;
+    }
+    bool done = (*checked)[id];
+    (*checked)[id] = 1;
+    return done;
+}
+
+// Validar que los nombres de elementos sean válidos (una vez por nombre distinto)
+bool validate_element_names(XMLNode *node) {
+    XMLTreeWalker walker;
+    xml_walker_init_list(&walker, node);
+    uint8_t *checked = NULL;
+    uint32_t checked_size = 0;
+    bool valid = true;
+    
+    while (valid && (node = xml_walker_next(&walker))) {
+        if (node->type == NODE_ELEMENT && !mark_checked(&checked, &checked_size, node->name_id)) {
+            valid = check_name(node->name, "elemento");
         }
     }
     
-    return validate_element_names(node->children) && validate_element_names(node->next);
+    free(checked);
+    return valid;
 }
 
-// Validar que los nombres de atributos sean válidos
+// Validar que los nombres de atributos sean válidos (una vez por nombre distinto)
 bool validate_attribute_names(XMLNode *node) {
-    if (!node) return true;
-    
-    if (node->type == NODE_ELEMENT && node->attributes) {
-        Attribute *attr = node->attributes->first;
-        while (attr) {
-            if (!attr->name || strlen(attr->name) == 0) {
-                printf("Error semántico: Atributo sin nombre\n");
-                return false;
-            }
-            
-            // Verificar que el nombre comience con letra o underscore
-            if (!isalpha(attr->name[0]) && attr->name[0] != '_') {
-                printf("Error semántico: Nombre de atributo '%s' inválido\n", attr->name);
-                return false;
-            }
-            
-            // Verificar que contenga solo caracteres válidos
-            for (int i = 1; i < strlen(attr->name); i++) {
-                if (!isalnum(attr->name[i]) && attr->name[i] != '_' && 
-                    attr->name[i] != '-' && attr->name[i] != '.') {
-                    printf("Error semántico: Nombre de atributo '%s' contiene caracteres inválidos\n", attr->name);
-                    return false;
+    XMLTreeWalker walker;
+    xml_walker_init_list(&walker, node);
+    uint8_t *checked = NULL;
+    uint32_t checked_size = 0;
+    bool valid = true;
+    
+    while (valid && (node = xml_walker_next(&walker))) {
+        if (node->type == NODE_ELEMENT && node->attributes) {
+            for (Attribute *attr = node->attributes->first; attr && valid; attr = attr->next) {
+                if (!mark_checked(&checked, &checked_size, attr->name_id)) {
+                    valid = check_name(attr->name, "atributo");
                 }
             }
-            
-            attr = attr->next;
         }
     }
     
-    return validate_attribute_names(node->children) && validate_attribute_names(node->next);
+    free(checked);
+    return valid;
 }
 
 // Verificar que el XML esté bien formado
@@ -130,7 +154,12 @@ SemanticEntry* find_or_create_entry(SemanticTable *table, const char *element_na
     SemanticEntry *new_entry = (SemanticEntry*)malloc(sizeof(SemanticEntry));
     new_entry->element_name = strdup(element_name);
     new_entry->count = 0;
+    new_entry->child_count = 0;
     new_entry->attribute_names = NULL;
+    new_entry->attribute_ids = NULL;
+    new_entry->attribute_counts = NULL;
+    new_entry->attribute_seen = NULL;
+    new_entry->attribute_values = NULL;
     new_entry->attr_count = 0;
     new_entry->next = table->entries;
     table->entries = new_entry;
@@ -138,6 +167,24 @@ SemanticEntry* find_or_create_entry(SemanticTable *table, const char *element_na
     return new_entry;
 }
 
+// Encontrar o crear entrada a partir del ID del nombre: la lista solo se
+// recorre la primera vez que aparece cada nombre
+SemanticEntry* find_or_create_entry_by_id(SemanticTable *table, uint32_t name_id, const char *element_name) {
+    if (name_id >= table->entries_by_id_size) {
+        uint32_t size = table->entries_by_id_size ? table->entries_by_id_size : 64;
+        while (size <= name_id) size *= 2;
+        table->entries_by_id = (SemanticEntry**)realloc(table->entries_by_id, size * sizeof(SemanticEntry*));
+        memset(table->entries_by_id + table->entries_by_id_size, 0,
+               (size - table->entries_by_id_size) * sizeof(SemanticEntry*));
+        table->entries_by_id_size = size;
+    }
+    
+    if (!table->entries_by_id[name_id]) {
+        table->entries_by_id[name_id] = find_or_create_entry(table, element_name);
+    }
+    return table->entries_by_id[name_id];
+}
+
 // Verificar si un atributo existe en una entrada
 bool attribute_exists_in_entry(SemanticEntry *entry, const char *attr_name) {
     for (int i = 0; i < entry->attr_count; i++) {
@@ -148,24 +195,110 @@ bool attribute_exists_in_entry(SemanticEntry *entry, const char *attr_name) {
     return false;
 }
 
+// Añadir un atributo nuevo al final de la entrada
+static int append_attribute(SemanticEntry *entry, const char *attr_name, uint32_t attr_id) {
+    int count = entry->attr_count + 1;
+    entry->attribute_names = (char**)realloc(entry->attribute_names, count * sizeof(char*));
+    entry->attribute_ids = (uint32_t*)realloc(entry->attribute_ids, count * sizeof(uint32_t));
+    entry->attribute_counts = (int*)realloc(entry->attribute_counts, count * sizeof(int));
+    entry->attribute_seen = (int*)realloc(entry->attribute_seen, count * sizeof(int));
+    entry->attribute_values = (ValueSketch*)realloc(entry->attribute_values, count * sizeof(ValueSketch));
+    entry->attribute_names[entry->attr_count] = strdup(attr_name);
+    entry->attribute_ids[entry->attr_count] = attr_id;
+    entry->attribute_counts[entry->attr_count] = 0;
+    entry->attribute_seen[entry->attr_count] = 0;
+    entry->attribute_values[entry->attr_count].count = 0;
+    return entry->attr_count++;
+}
+
 // Agregar atributo a una entrada
-void add_attribute_to_entry(SemanticEntry *entry, const char *attr_name) {
-    if (attribute_exists_in_entry(entry, attr_name)) {
+int add_attribute_to_entry(SemanticEntry *entry, const char *attr_name) {
+    for (int i = 0; i < entry->attr_count; i++) {
+        if (strcmp(entry->attribute_names[i], attr_name) == 0) {
+            return i;
+        }
+    }
+    return append_attribute(entry, attr_name, SYMBOL_NONE);
+}
+
+// Posición del atributo en la entrada por su ID (-1 si no se registró)
+static int attribute_id_in_entry(SemanticEntry *entry, uint32_t attr_id) {
+    for (int i = 0; i < entry->attr_count; i++) {
+        if (entry->attribute_ids[i] == attr_id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Agregar atributo por ID de nombre (entradas de un único documento)
+int add_attribute_id_to_entry(SemanticEntry *entry, uint32_t attr_id, const char *attr_name) {
+    int index = attribute_id_in_entry(entry, attr_id);
+    return index >= 0 ? index : append_attribute(entry, attr_name, attr_id);
+}
+
+// FNV-1a con una mezcla final: los bits altos también dependen de todo el valor
+static uint32_t hash_value(const char *value) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char*)value; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+// Guardar un hash si está entre los más pequeños (y no estaba ya)
+static void sketch_add(ValueSketch *sketch, uint32_t hash) {
+    if (sketch->count == SEMANTIC_SKETCH_SIZE && hash >= sketch->hashes[SEMANTIC_SKETCH_SIZE - 1]) {
         return;
     }
+    int position = sketch->count;
+    while (position > 0 && sketch->hashes[position - 1] > hash) position--;
+    if (position > 0 && sketch->hashes[position - 1] == hash) return;
     
-    entry->attribute_names = (char**)realloc(entry->attribute_names, 
-                                            (entry->attr_count + 1) * sizeof(char*));
-    entry->attribute_names[entry->attr_count] = strdup(attr_name);
-    entry->attr_count++;
+    int last = sketch->count < SEMANTIC_SKETCH_SIZE ? sketch->count++ : SEMANTIC_SKETCH_SIZE - 1;
+    memmove(sketch->hashes + position + 1, sketch->hashes + position, (last - position) * sizeof(uint32_t));
+    sketch->hashes[position] = hash;
+}
+
+// El sello attribute_seen evita contar dos veces el mismo elemento
+void count_attribute_value(SemanticEntry *entry, int index, const char *value) {
+    if (entry->attribute_seen[index] != entry->count) {
+        entry->attribute_seen[index] = entry->count;
+        entry->attribute_counts[index]++;
+    }
+    sketch_add(&entry->attribute_values[index], hash_value(value));
+}
+
+// Con el sketch lleno, los k hashes más pequeños ocupan una fracción
+// hashes[k-1] / 2^32 del espacio, así que hay unos (k - 1) / fracción valores
+double semantic_distinct_values(const SemanticEntry *entry, int index) {
+    const ValueSketch *sketch = &entry->attribute_values[index];
+    if (sketch->count < SEMANTIC_SKETCH_SIZE) {
+        return sketch->count;
+    }
+    double fraction = (sketch->hashes[SEMANTIC_SKETCH_SIZE - 1] + 1.0) / 4294967296.0;
+    double estimate = (SEMANTIC_SKETCH_SIZE - 1) / fraction;
+    return estimate < entry->attribute_counts[index] ? estimate : entry->attribute_counts[index];
 }
 
 // Construir tabla semántica
 void build_semantic_table(XMLNode *node, SemanticTable *table) {
-    if (!node) return;
+    XMLTreeWalker walker;
+    xml_walker_init_list(&walker, node);
     
-    if (node->type == NODE_ELEMENT) {
-        SemanticEntry *entry = find_or_create_entry(table, node->name);
+    while ((node = xml_walker_next(&walker))) {
+        // El padre ya se visitó, así que ya tiene entrada
+        if (node->parent && node->parent->name_id < table->entries_by_id_size &&
+            table->entries_by_id[node->parent->name_id]) {
+            table->entries_by_id[node->parent->name_id]->child_count++;
+        }
+        if (node->type != NODE_ELEMENT) continue;
+        
+        SemanticEntry *entry = find_or_create_entry_by_id(table, node->name_id, node->name);
         entry->count++;
         table->total_elements++;
         
@@ -173,22 +306,17 @@ void build_semantic_table(XMLNode *node, SemanticTable *table) {
         if (node->attributes) {
             Attribute *attr = node->attributes->first;
             while (attr) {
-                add_attribute_to_entry(entry, attr->name);
+                count_attribute_value(entry, add_attribute_id_to_entry(entry, attr->name_id, attr->name),
+                                      attr->value);
                 table->total_attributes++;
                 attr = attr->next;
             }
         }
-        
-        build_semantic_table(node->children, table);
     }
-    
-    build_semantic_table(node->next, table);
 }
 
-// Análisis semántico principal
-bool semantic_analyze(XMLNode *root, SemanticTable *table) {
-    printf("\n=== Iniciando análisis semántico ===\n");
-    
+// Análisis semántico sin mensajes de progreso (solo errores)
+bool semantic_check(XMLNode *root, SemanticTable *table) {
     // Verificar que el documento esté bien formado
     if (!check_well_formed(root)) {
         return false;
@@ -210,6 +338,121 @@ bool semantic_analyze(XMLNode *root, SemanticTable *table) {
     
     // Construir tabla semántica
     build_semantic_table(root, table);
+    return true;
+}
+
+// Análisis semántico sobre el árbol compacto: cada nombre distinto se valida
+// una sola vez. Los recorridos en orden de documento mantienen los mismos
+// errores y el mismo orden de entradas que semantic_check
+bool semantic_check_compact(CompactTree *tree, SemanticTable *table) {
+    if (tree->node_count == 0) {
+        printf("Error semántico: Documento XML vacío\n");
+        return false;
+    }
+    if (tree->type[0] != NODE_ELEMENT) {
+        printf("Error semántico: La raíz debe ser un elemento\n");
+        return false;
+    }
+    
+    // Establecer elemento raíz
+    table->has_root = true;
+    table->root_name = strdup(compact_node_name(tree, 0));
+    
+    // Bit 1: nombre de elemento validado; bit 2: nombre de atributo validado
+    uint32_t name_count = tree->names->count;
+    uint8_t *checked = (uint8_t*)calloc(name_count ? name_count : 1, 1);
+    bool valid = true;
+    
+    // Validar nombres de elementos
+    for (uint32_t i = 0; i < tree->node_count && valid; i++) {
+        uint32_t id = tree->name[i];
+        if (tree->type[i] != NODE_ELEMENT || (checked[id] & 1)) continue;
+        valid = check_name(symbol_name(tree->names, id), "elemento");
+        checked[id] |= 1;
+    }
+    
+    // Validar nombres de atributos
+    for (uint32_t a = 0; a < tree->attr_count && valid; a++) {
+        uint32_t id = tree->attr_name[a];
+        if (checked[id] & 2) continue;
+        valid = check_name(symbol_name(tree->names, id), "atributo");
+        checked[id] |= 2;
+    }
+    
+    // Construir tabla semántica
+    for (uint32_t i = 0; i < tree->node_count && valid; i++) {
+        uint32_t parent = tree->parent[i];
+        if (parent != COMPACT_NONE) {
+            table->entries_by_id[tree->name[parent]]->child_count++;
+        }
+        if (tree->type[i] != NODE_ELEMENT) continue;
+        
+        SemanticEntry *entry = find_or_create_entry_by_id(table, tree->name[i], compact_node_name(tree, i));
+        entry->count++;
+        table->total_elements++;
+        
+        uint32_t first = tree->span_start[i];
+        for (uint32_t a = first; a < first + tree->span_length[i]; a++) {
+            uint32_t id = tree->attr_name[a];
+            count_attribute_value(entry, add_attribute_id_to_entry(entry, id, symbol_name(tree->names, id)),
+                                  tree->text + tree->attr_value[a]);
+            table->total_attributes++;
+        }
+    }
+    
+    free(checked);
+    return valid;
+}
+
+// Evento de apertura: valida nombres y registra el elemento en la tabla.
+// Un nombre con entrada (o un atributo ya registrado en ella) ya se validó
+static int semantic_start_element(void *user_data, const char *name, uint32_t name_id,
+                                  const Attribute *attributes) {
+    SemanticTable *table = (SemanticTable*)user_data;
+    SemanticEntry *known = name_id < table->entries_by_id_size ? table->entries_by_id[name_id] : NULL;
+    
+    if (!known && !check_name(name, "elemento")) {
+        return 0;
+    }
+    for (const Attribute *attr = attributes; attr; attr = attr->next) {
+        if ((!known || attribute_id_in_entry(known, attr->name_id) < 0) &&
+            !check_name(attr->name, "atributo")) {
+            return 0;
+        }
+    }
+    
+    // El primer elemento abierto es la raíz
+    if (!table->has_root) {
+        table->has_root = true;
+        table->root_name = strdup(name);
+    }
+    
+    SemanticEntry *entry = find_or_create_entry_by_id(table, name_id, name);
+    entry->count++;
+    table->total_elements++;
+    for (const Attribute *attr = attributes; attr; attr = attr->next) {
+        count_attribute_value(entry, add_attribute_id_to_entry(entry, attr->name_id, attr->name), attr->value);
+        table->total_attributes++;
+    }
+    return 1;
+}
+
+// Análisis semántico sobre la interfaz de eventos (user_data: SemanticTable*);
+// la gramática ya garantiza un único elemento raíz
+const XMLSaxHandler semantic_sax_handler = {
+    semantic_start_element,
+    NULL,
+    NULL,
+    NULL
+};
+
+// Análisis semántico principal
+bool semantic_analyze(XMLNode *root, SemanticTable *table) {
+    printf("\n=== Iniciando análisis semántico ===\n");
+    
+    if (!semantic_check(root, table)) {
+        return false;
+    }
     
     // Imprimir tabla semántica
     print_semantic_table(table);
@@ -218,6 +461,31 @@ bool semantic_analyze(XMLNode *root, SemanticTable *table) {
     return true;
 }
 
+// Combinar la tabla 'src' en 'dest' (modo por lotes)
+void merge_semantic_table(SemanticTable *dest, SemanticTable *src) {
+    for (SemanticEntry *entry = src->entries; entry; entry = entry->next) {
+        SemanticEntry *target = find_or_create_entry(dest, entry->element_name);
+        target->count += entry->count;
+        target->child_count += entry->child_count;
+        for (int i = 0; i < entry->attr_count; i++) {
+            int index = add_attribute_to_entry(target, entry->attribute_names[i]);
+            target->attribute_counts[index] += entry->attribute_counts[i];
+            const ValueSketch *values = &entry->attribute_values[i];
+            for (int h = 0; h < values->count; h++) {
+                sketch_add(&target->attribute_values[index], values->hashes[h]);
+            }
+        }
+    }
+    
+    dest->total_elements += src->total_elements;
+    dest->total_attributes += src->total_attributes;
+    
+    if (src->has_root && !dest->has_root) {
+        dest->has_root = true;
+        dest->root_name = strdup(src->root_name);
+    }
+}
+
 // Imprimir tabla semántica
 void print_semantic_table(SemanticTable *table) {
     printf("\n--- Tabla Semántica ---\n");
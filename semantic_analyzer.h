@@ -2,13 +2,30 @@
 #define SEMANTIC_ANALYZER_H
 
 #include "xml_tree.h"
+#include "compact_tree.h"
+#include "xml_sax.h"
 #include <stdbool.h>
 
+// Valores distintos de un atributo: los SEMANTIC_SKETCH_SIZE hashes más
+// pequeños (KMV), de menor a mayor. Con menos valores distintos la cuenta es
+// exacta y con más se estima por la densidad de los hashes guardados
+#define SEMANTIC_SKETCH_SIZE 64
+
+typedef struct ValueSketch {
+    uint32_t hashes[SEMANTIC_SKETCH_SIZE];
+    int count;
+} ValueSketch;
+
 // Estructura para la tabla semántica
 typedef struct SemanticEntry {
     char *element_name;
     int count;
+    long child_count;           // Hijos de todos sus elementos (no se cuentan por eventos)
     char **attribute_names;
+    uint32_t *attribute_ids;    // ID de cada atributo (SYMBOL_NONE si se agregó por nombre)
+    int *attribute_counts;      // Elementos con cada atributo (uno repetido cuenta una vez)
+    int *attribute_seen;        // Último elemento (su número en count) contado en cada atributo
+    ValueSketch *attribute_values;
     int attr_count;
     struct SemanticEntry *next;
 } SemanticEntry;
@@ -19,13 +36,24 @@ typedef struct SemanticTable {
     int total_attributes;
     bool has_root;
     char *root_name;
+    
+    // Entradas por ID de nombre: válido solo para una tabla que se llena
+    // desde un único documento (las tablas combinadas usan los nombres)
+    SemanticEntry **entries_by_id;
+    uint32_t entries_by_id_size;
 } SemanticTable;
 
 // Funciones del analizador semántico
 void init_semantic_table(SemanticTable *table);
 void free_semantic_table(SemanticTable *table);
 bool semantic_analyze(XMLNode *root, SemanticTable *table);
+bool semantic_check(XMLNode *root, SemanticTable *table);
+bool semantic_check_compact(CompactTree *tree, SemanticTable *table);
 void print_semantic_table(SemanticTable *table);
+void merge_semantic_table(SemanticTable *dest, SemanticTable *src);
+
+// Análisis semántico por eventos, sin árbol (user_data: SemanticTable*)
+extern const XMLSaxHandler semantic_sax_handler;
 
 // Funciones de validación
 bool validate_xml_structure(XMLNode *root);
@@ -35,7 +63,16 @@ bool check_well_formed(XMLNode *root);
 
 // Funciones auxiliares
 SemanticEntry* find_or_create_entry(SemanticTable *table, const char *element_name);
-void add_attribute_to_entry(SemanticEntry *entry, const char *attr_name);
+SemanticEntry* find_or_create_entry_by_id(SemanticTable *table, uint32_t name_id, const char *element_name);
+// Las dos devuelven la posición del atributo en la entrada
+int add_attribute_to_entry(SemanticEntry *entry, const char *attr_name);
+int add_attribute_id_to_entry(SemanticEntry *entry, uint32_t attr_id, const char *attr_name);
 bool attribute_exists_in_entry(SemanticEntry *entry, const char *attr_name);
+// Contar el atributo 'index' con su valor en el último elemento sumado a
+// entry->count; un atributo repetido en el elemento cuenta una vez
+void count_attribute_value(SemanticEntry *entry, int index, const char *value);
+// Valores distintos del atributo 'index' (estimados a partir de
+// SEMANTIC_SKETCH_SIZE valores)
+double semantic_distinct_values(const SemanticEntry *entry, int index);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "simd_scan.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+// Tabla de funciones de la implementación activa
+typedef struct ScanOps {
+    const char* (*find_char)(const char *p, const char *end, char c);
+    const char* (*find_comment_end)(const char *p, const char *end);
+    size_t (*count_newlines)(const char *p, const char *end);
+} ScanOps;
+
+// ---- Implementación escalar ----
+
+static const char* find_char_scalar(const char *p, const char *end, char c) {
+    const char *hit = memchr(p, c, (size_t)(end - p));
+    return hit ? hit : end;
+}
+
+static const char* find_comment_end_scalar(const char *p, const char *end) {
+    while (end - p >= 3) {
+        p = memchr(p, '-', (size_t)(end - p - 2));
+        if (!p) return end;
+        if (p[1] == '-' && p[2] == '>') return p;
+        p++;
+    }
+    return end;
+}
+
+static size_t count_newlines_scalar(const char *p, const char *end) {
+    size_t count = 0;
+    for (; p < end; p++) {
+        if (*p == '\n') count++;
+    }
+    return count;
+}
+
+#ifdef SCAN_X86
+// ---- SSE2: bloques de 16 bytes ----
+
+__attribute__((target("sse2")))
+static const char* find_char_sse2(const char *p, const char *end, char c) {
+    __m128i needle = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)p);
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return find_char_scalar(p, end, c);
+}
+
+__attribute__((target("sse2")))
+static const char* find_comment_end_sse2(const char *p, const char *end) {
+    __m128i dash = _mm_set1_epi8('-');
+    __m128i gt = _mm_set1_epi8('>');
+    while (end - p >= 18) {
+        __m128i b0 = _mm_loadu_si128((const __m128i*)p);
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(p + 1));
+        __m128i b2 = _mm_loadu_si128((const __m128i*)(p + 2));
+        __m128i hit = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, dash),
+                                                  _mm_cmpeq_epi8(b1, dash)),
+                                    _mm_cmpeq_epi8(b2, gt));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return find_comment_end_scalar(p, end);
+}
+
+__attribute__((target("sse2,popcnt")))
+static size_t count_newlines_sse2(const char *p, const char *end) {
+    __m128i nl = _mm_set1_epi8('\n');
+    size_t count = 0;
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)p);
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(block, nl)));
+        p += 16;
+    }
+    return count + count_newlines_scalar(p, end);
+}
+
+// ---- AVX2: bloques de 32 bytes ----
+
+__attribute__((target("avx2")))
+static const char* find_char_avx2(const char *p, const char *end, char c) {
+    __m256i needle = _mm256_set1_epi8(c);
+    while (end - p >= 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)p);
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return find_char_sse2(p, end, c);
+}
+
+__attribute__((target("avx2")))
+static const char* find_comment_end_avx2(const char *p, const char *end) {
+    __m256i dash = _mm256_set1_epi8('-');
+    __m256i gt = _mm256_set1_epi8('>');
+    while (end - p >= 34) {
+        __m256i b0 = _mm256_loadu_si256((const __m256i*)p);
+        __m256i b1 = _mm256_loadu_si256((const __m256i*)(p + 1));
+        __m256i b2 = _mm256_loadu_si256((const __m256i*)(p + 2));
+        __m256i hit = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(b0, dash),
+                                                        _mm256_cmpeq_epi8(b1, dash)),
+                                       _mm256_cmpeq_epi8(b2, gt));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hit);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return find_comment_end_sse2(p, end);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t count_newlines_avx2(const char *p, const char *end) {
+    __m256i nl = _mm256_set1_epi8('\n');
+    size_t count = 0;
+    while (end - p >= 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)p);
+        count += __builtin_popcount((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, nl)));
+        p += 32;
+    }
+    return count + count_newlines_sse2(p, end);
+}
+#endif
+
+static const ScanOps scalar_ops = { find_char_scalar, find_comment_end_scalar, count_newlines_scalar };
+#ifdef SCAN_X86
+static const ScanOps sse2_ops = { find_char_sse2, find_comment_end_sse2, count_newlines_sse2 };
+static const ScanOps avx2_ops = { find_char_avx2, find_comment_end_avx2, count_newlines_avx2 };
+#endif
+
+static const ScanOps *active_ops = &scalar_ops;
+static ScanBackend active_backend = SCAN_SCALAR;
+
+// Seleccionar implementación en tiempo de ejecución
+ScanBackend scan_init(int allow_simd) {
+    active_ops = &scalar_ops;
+    active_backend = SCAN_SCALAR;
+
+#ifdef SCAN_X86
+    if (allow_simd) {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+            active_ops = &avx2_ops;
+            active_backend = SCAN_AVX2;
+        } else if (__builtin_cpu_supports("sse2") && __builtin_cpu_supports("popcnt")) {
+            active_ops = &sse2_ops;
+            active_backend = SCAN_SSE2;
+        }
+    }
+#else
+    (void)allow_simd;
+#endif
+
+    return active_backend;
+}
+
+// Nombre de la implementación activa
+const char* scan_backend_name(void) {
+    switch (active_backend) {
+        case SCAN_AVX2: return "AVX2";
+        case SCAN_SSE2: return "SSE2";
+        default: return "escalar";
+    }
+}
+
+const char* scan_find_char(const char *p, const char *end, char c) {
+    return active_ops->find_char(p, end, c);
+}
+
+const char* scan_find_comment_end(const char *p, const char *end) {
+    return active_ops->find_comment_end(p, end);
+}
+
+size_t scan_count_newlines(const char *p, const char *end) {
+    return active_ops->count_newlines(p, end);
+}
@@ -0,0 +1,22 @@
+#ifndef SIMD_SCAN_H
+#define SIMD_SCAN_H
+
+#include <stddef.h>
+
+// Implementaciones disponibles para la capa de búsqueda vectorizada
+typedef enum {
+    SCAN_SCALAR,
+    SCAN_SSE2,
+    SCAN_AVX2
+} ScanBackend;
+
+// Seleccionar la implementación según la CPU (allow_simd = 0 fuerza la escalar)
+ScanBackend scan_init(int allow_simd);
+const char* scan_backend_name(void);
+
+// Búsquedas sobre [p, end): devuelven end si no hay coincidencia
+const char* scan_find_char(const char *p, const char *end, char c);
+const char* scan_find_comment_end(const char *p, const char *end);  // Inicio de "-->"
+size_t scan_count_newlines(const char *p, const char *end);
+
+#endif
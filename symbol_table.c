@@ -0,0 +1,92 @@
+#include "symbol_table.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Hash FNV-1a de los primeros 'len' bytes de un nombre
+static uint32_t hash_name(const char *name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Posición del nombre en la tabla hash (ocupada por él o libre)
+static uint32_t find_slot(const SymbolTable *table, const char *name, size_t len) {
+    uint32_t mask = table->slot_count - 1;
+    uint32_t slot = hash_name(name, len) & mask;
+    while (table->slots[slot]) {
+        const char *stored = table->names[table->slots[slot] - 1];
+        if (strncmp(stored, name, len) == 0 && stored[len] == '\0') {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Duplicar la tabla hash y reinsertar los nombres
+static void grow_slots(SymbolTable *table) {
+    free(table->slots);
+    table->slot_count = table->slot_count ? table->slot_count * 2 : 64;
+    table->slots = (uint32_t*)calloc(table->slot_count, sizeof(uint32_t));
+    for (uint32_t id = 0; id < table->count; id++) {
+        const char *name = table->names[id];
+        table->slots[find_slot(table, name, strlen(name))] = id + 1;
+    }
+}
+
+void init_symbol_table(SymbolTable *table) {
+    table->names = NULL;
+    table->count = 0;
+    table->capacity = 0;
+    table->slots = NULL;
+    table->slot_count = 0;
+    arena_init(&table->strings, 4096);
+}
+
+void free_symbol_table(SymbolTable *table) {
+    free(table->names);
+    free(table->slots);
+    arena_release(&table->strings);
+    init_symbol_table(table);
+}
+
+// Obtener el ID de un nombre, agregándolo si es nuevo
+uint32_t symbol_intern(SymbolTable *table, const char *name, size_t len) {
+    if ((table->count + 1) * 2 > table->slot_count) {
+        grow_slots(table);
+    }
+
+    uint32_t slot = find_slot(table, name, len);
+    if (table->slots[slot]) {
+        return table->slots[slot] - 1;
+    }
+
+    if (table->count == table->capacity) {
+        table->capacity = table->capacity ? table->capacity * 2 : 32;
+        table->names = (char**)realloc(table->names, table->capacity * sizeof(char*));
+    }
+    table->names[table->count] = arena_strndup(&table->strings, name, len);
+    table->slots[slot] = table->count + 1;
+    return table->count++;
+}
+
+// Buscar el ID de un nombre sin agregarlo
+uint32_t symbol_lookup(const SymbolTable *table, const char *name) {
+    if (table->slot_count == 0) return SYMBOL_NONE;
+    uint32_t slot = find_slot(table, name, strlen(name));
+    return table->slots[slot] ? table->slots[slot] - 1 : SYMBOL_NONE;
+}
+
+const char* symbol_name(const SymbolTable *table, uint32_t id) {
+    return id < table->count ? table->names[id] : NULL;
+}
+
+// Bytes reservados por los nombres, el índice por ID y la tabla hash
+size_t symbol_table_memory(const SymbolTable *table) {
+    return table->strings.bytes_reserved + table->capacity * sizeof(char*) +
+           table->slot_count * sizeof(uint32_t);
+}
@@ -0,0 +1,32 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+#define SYMBOL_NONE 0xFFFFFFFFu
+
+// Tabla de símbolos de un documento: cada nombre distinto de elemento o
+// atributo se guarda una sola vez y recibe un ID denso (0, 1, 2, ...) en
+// orden de aparición. Comparar nombres internados es comparar enteros
+typedef struct SymbolTable {
+    char **names;           // Nombre por ID
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t *slots;        // Tabla hash abierta: ID + 1 por posición (0 = libre)
+    uint32_t slot_count;
+    Arena strings;          // Una copia por nombre distinto
+} SymbolTable;
+
+void init_symbol_table(SymbolTable *table);
+void free_symbol_table(SymbolTable *table);
+
+// ID de un nombre de 'len' bytes, agregándolo si es nuevo
+uint32_t symbol_intern(SymbolTable *table, const char *name, size_t len);
+// ID de un nombre o SYMBOL_NONE si no aparece en el documento
+uint32_t symbol_lookup(const SymbolTable *table, const char *name);
+const char* symbol_name(const SymbolTable *table, uint32_t id);
+size_t symbol_table_memory(const SymbolTable *table);
+
+#endif
@@ -0,0 +1,229 @@
+#include "thread_pool.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+typedef struct PoolTask {
+    PoolTaskFunc func;
+    void *arg;
+} PoolTask;
+
+// Cola doble circular de un hilo
+typedef struct WorkerQueue {
+    pthread_mutex_t lock;
+    PoolTask *tasks;
+    int head;       // Extremo de robo
+    int count;
+    int capacity;
+} WorkerQueue;
+
+typedef struct WorkerInfo {
+    ThreadPool *pool;
+    int index;
+} WorkerInfo;
+
+struct ThreadPool {
+    int thread_count;
+    pthread_t *threads;
+    WorkerInfo *workers;
+    WorkerQueue *queues;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_available;
+    pthread_cond_t all_done;
+    long queued;       // Tareas en colas o a punto de entrar, aún sin tomar
+    long pending;      // Tareas encoladas y no terminadas
+    int next_queue;
+    int shutdown;
+};
+
+// Añadir tarea por el final de la cola
+static void queue_push(WorkerQueue *queue, PoolTask task) {
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count == queue->capacity) {
+        int capacity = queue->capacity == 0 ? 64 : queue->capacity * 2;
+        PoolTask *tasks = (PoolTask*)malloc(capacity * sizeof(PoolTask));
+        for (int i = 0; i < queue->count; i++) {
+            tasks[i] = queue->tasks[(queue->head + i) % queue->capacity];
+        }
+        free(queue->tasks);
+        queue->tasks = tasks;
+        queue->capacity = capacity;
+        queue->head = 0;
+    }
+    queue->tasks[(queue->head + queue->count) % queue->capacity] = task;
+    queue->count++;
+    pthread_mutex_unlock(&queue->lock);
+}
+
+// Tomar tarea por el final (propietario) o por el principio (robo)
+static int queue_take(WorkerQueue *queue, PoolTask *task, int steal) {
+    int found = 0;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count > 0) {
+        if (steal) {
+            *task = queue->tasks[queue->head];
+            queue->head = (queue->head + 1) % queue->capacity;
+        } else {
+            *task = queue->tasks[(queue->head + queue->count - 1) % queue->capacity];
+        }
+        queue->count--;
+        found = 1;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+// Buscar trabajo: primero la cola propia, luego robar a las demás
+static int find_task(ThreadPool *pool, int index, PoolTask *task) {
+    if (queue_take(&pool->queues[index], task, 0)) return 1;
+    for (int i = 1; i < pool->thread_count; i++) {
+        int victim = (index + i) % pool->thread_count;
+        if (queue_take(&pool->queues[victim], task, 1)) return 1;
+    }
+    return 0;
+}
+
+static void* worker_main(void *arg) {
+    WorkerInfo *info = (WorkerInfo*)arg;
+    ThreadPool *pool = info->pool;
+    PoolTask task;
+
+    while (1) {
+        if (find_task(pool, info->index, &task)) {
+            pthread_mutex_lock(&pool->lock);
+            pool->queued--;
+            pthread_mutex_unlock(&pool->lock);
+
+            task.func(task.arg, info->index);
+
+            pthread_mutex_lock(&pool->lock);
+            pool->pending--;
+            if (pool->pending == 0) {
+                pthread_cond_broadcast(&pool->all_done);
+            }
+            pthread_mutex_unlock(&pool->lock);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        while (pool->queued == 0 && !pool->shutdown) {
+            pthread_cond_wait(&pool->work_available, &pool->lock);
+        }
+        int stop = pool->shutdown && pool->queued == 0;
+        pthread_mutex_unlock(&pool->lock);
+        if (stop) break;
+    }
+    return NULL;
+}
+
+// Crear pool con 'threads' hilos (0 = número de procesadores)
+ThreadPool* thread_pool_create(int threads) {
+    if (threads <= 0) threads = thread_pool_default_threads();
+
+    ThreadPool *pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    pool->thread_count = threads;
+    pool->threads = (pthread_t*)malloc(threads * sizeof(pthread_t));
+    pool->workers = (WorkerInfo*)malloc(threads * sizeof(WorkerInfo));
+    pool->queues = (WorkerQueue*)calloc(threads, sizeof(WorkerQueue));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_available, NULL);
+    pthread_cond_init(&pool->all_done, NULL);
+
+    for (int i = 0; i < threads; i++) {
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+    }
+    for (int i = 0; i < threads; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->workers[i]) != 0) {
+            fprintf(stderr, "Error: no se pudo crear el hilo %d\n", i);
+            exit(1);
+        }
+    }
+    return pool;
+}
+
+// Terminar los hilos (tras completar el trabajo pendiente) y liberar el pool
+void thread_pool_destroy(ThreadPool *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_mutex_destroy(&pool->queues[i].lock);
+        free(pool->queues[i].tasks);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_available);
+    pthread_cond_destroy(&pool->all_done);
+    free(pool->queues);
+    free(pool->workers);
+    free(pool->threads);
+    free(pool);
+}
+
+// Encolar una tarea en la cola de un hilo concreto
+void thread_pool_submit_to(ThreadPool *pool, int worker, PoolTaskFunc func, void *arg) {
+    PoolTask task = { func, arg };
+
+    // queued sube antes de encolar: un hilo que tome la tarea enseguida no
+    // puede dejarlo en negativo
+    pthread_mutex_lock(&pool->lock);
+    pool->pending++;
+    pool->queued++;
+    pthread_mutex_unlock(&pool->lock);
+
+    queue_push(&pool->queues[worker % pool->thread_count], task);
+
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Encolar una tarea repartiendo de forma circular
+void thread_pool_submit(ThreadPool *pool, PoolTaskFunc func, void *arg) {
+    pthread_mutex_lock(&pool->lock);
+    int worker = pool->next_queue;
+    pool->next_queue = (pool->next_queue + 1) % pool->thread_count;
+    pthread_mutex_unlock(&pool->lock);
+
+    thread_pool_submit_to(pool, worker, func, arg);
+}
+
+// Esperar a que terminen todas las tareas
+void thread_pool_wait(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->all_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int thread_pool_size(ThreadPool *pool) {
+    return pool->thread_count;
+}
+
+// Número de procesadores disponibles
+int thread_pool_default_threads(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
@@ -0,0 +1,24 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Tarea del pool: recibe su argumento y el índice del hilo que la ejecuta
+typedef void (*PoolTaskFunc)(void *arg, int worker);
+
+typedef struct ThreadPool ThreadPool;
+
+// Pool de hilos con robo de trabajo: cada hilo tiene su propia cola doble,
+// consume por el final (LIFO) y roba por el principio (FIFO) de las demás
+ThreadPool* thread_pool_create(int threads);
+void thread_pool_destroy(ThreadPool *pool);
+
+// Encolar una tarea (reparto circular entre colas)
+void thread_pool_submit(ThreadPool *pool, PoolTaskFunc func, void *arg);
+// Encolar una tarea en la cola de un hilo concreto (subtareas desde una tarea)
+void thread_pool_submit_to(ThreadPool *pool, int worker, PoolTaskFunc func, void *arg);
+// Esperar a que terminen todas las tareas encoladas
+void thread_pool_wait(ThreadPool *pool);
+
+int thread_pool_size(ThreadPool *pool);
+int thread_pool_default_threads(void);
+
+#endif
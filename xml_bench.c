@@ -0,0 +1,795 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "xml_parser.h"
+#include "parser.tab.h"
+#include "simd_scan.h"
+#include "xpath_engine.h"
+#include "query_cache.h"
+#include "query_set.h"
+#include "thread_pool.h"
+
+// Benchmarks y comprobaciones del compilador XML (xml_bench.exe): cada vía
+// nueva de consulta se compara con xpath_execute sobre el mismo documento
+
+int yylex(YYSTYPE *yylval_param, void *yyscanner);
+
+// Ejecutar solo el analizador léxico sobre ctx->input y medir su velocidad
+static double benchmark_lexer(XMLParseContext *ctx, int fast_path, long *tokens) {
+    YYSTYPE value;
+    *tokens = 0;
+    ctx->fast_path = fast_path;
+
+    init_xml_document(&ctx->document);
+    double start = xml_time_now();
+    if (!lexer_init(ctx)) {
+        free_xml_document(&ctx->document);
+        return 0;
+    }
+    while (yylex(&value, ctx->scanner) != 0) {
+        (*tokens)++;
+    }
+    double elapsed = xml_time_now() - start;
+
+    lexer_destroy(ctx);
+    free_xml_document(&ctx->document);
+    return elapsed;
+}
+
+// Comparar el DFA de flex con la vía rápida vectorizada (--lex-bench)
+static int run_lexer_benchmark(XMLParseContext *ctx, const char *path) {
+    long tokens = 0;
+
+    if (!xml_input_open(&ctx->input, path, ctx->use_mmap)) {
+        perror("Error al abrir el archivo");
+        return 1;
+    }
+
+    printf("Benchmark del analizador léxico (%zu bytes, %s)\n",
+           ctx->input.size, ctx->input.mapped ? "mmap" : "flujo");
+
+    double dfa = benchmark_lexer(ctx, 0, &tokens);
+    size_t bytes = ctx->input.mapped ? ctx->input.size : ctx->bytes_read;
+    printf("- DFA de flex:        %10.3f ms  %8.2f MB/s  (%ld tokens)\n",
+           dfa * 1000.0, bytes / dfa / (1024.0 * 1024.0), tokens);
+
+    if (ctx->input.mapped) {
+        double fast = benchmark_lexer(ctx, 1, &tokens);
+        printf("- Vía rápida (%s): %10.3f ms  %8.2f MB/s  (%ld tokens)\n",
+               scan_backend_name(), fast * 1000.0, bytes / fast / (1024.0 * 1024.0), tokens);
+        printf("- Aceleración: %.2fx\n", dfa / fast);
+    } else {
+        printf("La vía vectorizada requiere el documento mapeado en memoria\n");
+    }
+
+    xml_input_close(&ctx->input);
+    return 0;
+}
+
+// Analizar documentos planos de n, 2n, 4n y 8n hijos y comprobar que el
+// tiempo crece linealmente con el número de hermanos (--wide-bench N)
+static int run_wide_benchmark(long children) {
+    printf("Benchmark de documento ancho (hijos directos de la raíz)\n");
+    printf("      Hijos   Tiempo (ms)   ns/hijo   Proporción\n");
+
+    double previous = 0;
+    for (int step = 0; step < 4; step++) {
+        long count = children << step;
+        FILE *file = tmpfile();
+        if (!file) {
+            perror("Error al crear el archivo temporal");
+            return 1;
+        }
+        fprintf(file, "<root>");
+        for (long i = 0; i < count; i++) {
+            fprintf(file, "<item id=\"%ld\">x</item>", i);
+        }
+        fprintf(file, "</root>");
+        rewind(file);
+
+        XMLParseContext ctx;
+        init_parse_context(&ctx);
+        ctx.verbose = 0;
+        ctx.input.file = file;
+
+        // parse_input cierra el archivo temporal junto con la entrada
+        int status = parse_xml_input(&ctx);
+        if (status != 1) {
+            printf("✗ Error al analizar el documento de %ld hijos\n", count);
+            free_parse_context(&ctx);
+            return 1;
+        }
+
+        double elapsed = ctx.parse_time;
+        printf("  %9ld  %12.3f  %8.1f", count, elapsed * 1000.0, elapsed * 1e9 / count);
+        if (previous > 0) {
+            printf("  %9.2fx", elapsed / previous);
+        }
+        printf("\n");
+        previous = elapsed;
+        free_parse_context(&ctx);
+    }
+
+    printf("Crecimiento lineal: proporción cercana a 2x al duplicar los hijos\n");
+    return 0;
+}
+
+// Construir sin el parser un árbol de 'n' niveles anidados (profundo) o de
+// 'n' hijos directos (ancho); cada elemento lleva un atributo
+static XMLNode* build_stress_tree(XMLDocument *doc, long n, int deep) {
+    uint32_t name = symbol_intern(&doc->names, "nodo", 4);
+    uint32_t attr_name = symbol_intern(&doc->names, "id", 2);
+    char *value = arena_strdup(&doc->strings, "1");
+    char *text = arena_strdup(&doc->strings, "texto");
+
+    if (deep) {
+        XMLNode *node = create_text_node(doc, text);
+        for (long i = 0; i < n; i++) {
+            AttributeList *attrs = add_attribute(doc, NULL, create_attribute(doc, attr_name, value));
+            node = create_element(doc, name, attrs, node);
+        }
+        return node;
+    }
+
+    NodeList children = { NULL, NULL };
+    for (long i = 0; i < n; i++) {
+        AttributeList *attrs = add_attribute(doc, NULL, create_attribute(doc, attr_name, value));
+        children = add_content(children, create_element(doc, name, attrs, create_text_node(doc, text)));
+    }
+    return create_element(doc, name, NULL, children.first);
+}
+
+// Comprobar un resultado del recorrido y mostrar su tiempo
+static int stress_check(const char *label, long got, long expected, double start) {
+    printf("  %s %-24s %10ld  (%.3f ms)\n", got == expected ? "✓" : "✗", label, got,
+           (xml_time_now() - start) * 1000.0);
+    return got == expected;
+}
+
+// Recorrer árboles muy profundos y muy anchos con todas las funciones del
+// árbol, del análisis semántico y de XPath (--stress N)
+static int run_stress_test(long n) {
+    int ok = 1;
+
+    for (int deep = 1; deep >= 0; deep--) {
+        XMLDocument doc;
+        init_xml_document(&doc);
+        XMLNode *root = build_stress_tree(&doc, n, deep);
+        long elements = deep ? n : n + 1;
+
+        printf("Árbol %s: %ld elementos\n", deep ? "profundo" : "ancho", elements);
+
+        double start = xml_time_now();
+        ok &= stress_check("count_elements", count_elements(root), elements, start);
+
+        start = xml_time_now();
+        ok &= stress_check("count_attributes", count_attributes(root), n, start);
+
+        start = xml_time_now();
+        ok &= stress_check("validate_element_names", validate_element_names(root), 1, start);
+
+        start = xml_time_now();
+        ok &= stress_check("validate_attribute_names", validate_attribute_names(root), 1, start);
+
+        SemanticTable table;
+        init_semantic_table(&table);
+        start = xml_time_now();
+        semantic_check(root, &table);
+        ok &= stress_check("build_semantic_table", table.total_elements, elements, start);
+        free_semantic_table(&table);
+
+        start = xml_time_now();
+        doc.root = root;
+        XPathResult *matches = xpath_query(&doc, "//nodo");
+        ok &= stress_check("xpath //nodo", matches->count, elements, start);
+        free_xpath_result(matches);
+
+        start = xml_time_now();
+        matches = xpath_query(&doc, "//nodo[@id='1']");
+        ok &= stress_check("xpath //nodo[@id='1']", matches->count, n, start);
+        free_xpath_result(matches);
+
+        start = xml_time_now();
+        matches = xpath_query(&doc, "//nodo[contains(text(),'text')]");
+        ok &= stress_check("xpath contains()", matches->count, deep ? 1 : n, start);
+        free_xpath_result(matches);
+
+        // Las tres consultas juntas en un recorrido
+        start = xml_time_now();
+        XPathPlan *set_plans[3] = { xpath_compile("//nodo"), xpath_compile("//nodo[@id='1']"),
+                                    xpath_compile("//nodo[contains(text(),'text')]") };
+        QuerySet *set = query_set_compile(set_plans, 3);
+        XPathResult *set_results[3];
+        query_set_execute(set, &doc, set_results);
+        long set_matches = 0;
+        for (int i = 0; i < 3; i++) {
+            set_matches += set_results[i]->count;
+            free_xpath_result(set_results[i]);
+            free_xpath_plan(set_plans[i]);
+        }
+        free_query_set(set);
+        ok &= stress_check("conjunto de consultas", set_matches, elements + n + (deep ? 1 : n), start);
+
+        // Un cambio en el árbol invalida los índices de nombres, de atributos
+        // y de texto
+        AttributeList *extra_attrs = add_attribute(&doc, NULL,
+            create_attribute(&doc, symbol_lookup(&doc.names, "id"), arena_strdup(&doc.strings, "1")));
+        XMLNode *extra = create_element(&doc, symbol_lookup(&doc.names, "nodo"), extra_attrs,
+                                        create_text_node(&doc, arena_strdup(&doc.strings, "texto")));
+        extra->parent = root;
+        extra->next = root->children;
+        root->children = extra;
+        xml_document_changed(&doc);
+
+        // Con los índices desactualizados el cursor recorre el árbol y se
+        // detiene en el primer nodo
+        XPathPlan *plan = xpath_compile("//nodo[@id='1']");
+        start = xml_time_now();
+        ok &= stress_check("exists tras cambio", xpath_exists(plan, &doc), 1, start);
+        free_xpath_plan(plan);
+
+        start = xml_time_now();
+        matches = xpath_query(&doc, "//nodo");
+        ok &= stress_check("xpath //nodo tras cambio", matches->count, elements + 1, start);
+        free_xpath_result(matches);
+
+        start = xml_time_now();
+        matches = xpath_query(&doc, "//nodo[@id='1']");
+        ok &= stress_check("[@id='1'] tras cambio", matches->count, n + 1, start);
+        free_xpath_result(matches);
+
+        start = xml_time_now();
+        matches = xpath_query(&doc, "//nodo[contains(text(),'text')]");
+        ok &= stress_check("contains() tras cambio", matches->count, deep ? 2 : n + 1, start);
+        free_xpath_result(matches);
+
+        free_xml_document(&doc);
+    }
+
+    printf(ok ? "Todas las comprobaciones correctas\n" : "Hay comprobaciones fallidas\n");
+    return ok ? 0 : 1;
+}
+
+// Memoria de los nodos del árbol de punteros (nodos, atributos y listas)
+static size_t pointer_tree_node_memory(XMLNode *root) {
+    XMLTreeWalker walker;
+    XMLNode *node;
+    size_t bytes = 0;
+
+    xml_walker_init(&walker, root);
+    while ((node = xml_walker_next(&walker))) {
+        bytes += sizeof(XMLNode);
+        if (node->type == NODE_ELEMENT && node->attributes) {
+            bytes += sizeof(AttributeList) + node->attributes->count * sizeof(Attribute);
+        }
+    }
+    return bytes;
+}
+
+// Comparar el árbol de punteros con el compacto: memoria de los nodos,
+// consultas //nombre por cada nombre de elemento y análisis semántico
+// (--compact-bench)
+static int run_compact_benchmark(XMLDocument *doc) {
+    XMLNode *root = doc->root;
+    const int rounds = 10;
+    CompactTree tree;
+
+    double start = xml_time_now();
+    compact_tree_build(&tree, doc);
+    double build_time = xml_time_now() - start;
+
+    size_t pointer_bytes = pointer_tree_node_memory(root);
+    size_t compact_bytes = compact_tree_node_memory(&tree);
+    printf("Árbol compacto: %u nodos, %u atributos, %u nombres (construcción %.3f ms)\n",
+           tree.node_count, tree.attr_count, tree.names->count, build_time * 1000.0);
+    printf("Memoria de nodos: punteros %zu KB, compacto %zu KB (%.1f bytes/nodo frente a %.1f)\n",
+           pointer_bytes / 1024, compact_bytes / 1024,
+           tree.node_count ? (double)compact_bytes / tree.node_count : 0.0,
+           tree.node_count ? (double)pointer_bytes / tree.node_count : 0.0);
+
+    // Consultas //nombre para cada nombre de elemento, 'rounds' veces
+    int ok = 1;
+    long matches = 0;
+    double pointer_time = 0, compact_time = 0;
+    int element_names = 0;
+    char query[256];
+    uint32_t name_count = tree.names->count;
+    uint8_t *is_element = (uint8_t*)calloc(name_count ? name_count : 1, 1);
+    for (uint32_t i = 0; i < tree.node_count; i++) {
+        if (tree.type[i] == NODE_ELEMENT) is_element[tree.name[i]] = 1;
+    }
+    for (uint32_t id = 0; id < name_count; id++) {
+        if (!is_element[id]) continue;
+        element_names++;
+        snprintf(query, sizeof(query), "//%s", symbol_name(tree.names, id));
+
+        for (int round = 0; round < rounds; round++) {
+            start = xml_time_now();
+            XPathResult *pointer_result = xpath_query(doc, query);
+            pointer_time += xml_time_now() - start;
+
+            start = xml_time_now();
+            CompactResult *compact_result = xpath_query_compact(&tree, query);
+            compact_time += xml_time_now() - start;
+
+            if (pointer_result->count != compact_result->count) ok = 0;
+            if (round == 0) matches += compact_result->count;
+            free_xpath_result(pointer_result);
+            free_compact_result(compact_result);
+        }
+    }
+    free(is_element);
+    printf("Consultas //nombre (%d nombres x %d): punteros %.3f ms, compacto %.3f ms (%ld nodos)\n",
+           element_names, rounds, pointer_time * 1000.0, compact_time * 1000.0, matches);
+
+    // Análisis semántico sobre cada representación
+    SemanticTable pointer_table, compact_table;
+    init_semantic_table(&pointer_table);
+    init_semantic_table(&compact_table);
+
+    start = xml_time_now();
+    semantic_check(root, &pointer_table);
+    pointer_time = xml_time_now() - start;
+
+    start = xml_time_now();
+    semantic_check_compact(&tree, &compact_table);
+    compact_time = xml_time_now() - start;
+
+    if (pointer_table.total_elements != compact_table.total_elements ||
+        pointer_table.total_attributes != compact_table.total_attributes) {
+        ok = 0;
+    }
+    printf("Análisis semántico: punteros %.3f ms, compacto %.3f ms\n",
+           pointer_time * 1000.0, compact_time * 1000.0);
+
+    free_semantic_table(&pointer_table);
+    free_semantic_table(&compact_table);
+    free_compact_tree(&tree);
+
+    printf(ok ? "✓ Resultados idénticos en ambas representaciones\n"
+              : "✗ Las representaciones difieren\n");
+    return ok ? 0 : 1;
+}
+
+// Escalabilidad de la evaluación paralela sin índices con 1, 2, 4, ... hilos
+// hasta 'max_threads', comparada con la ejecución normal por índices; cada
+// resultado se verifica contra el de xpath_execute (--parallel-bench)
+static int run_parallel_benchmark(XMLDocument *doc, XPathPlan **plans, int count, int max_threads) {
+    const int rounds = 5;
+    int ok = 1;
+
+    xml_number_nodes(doc);
+    printf("\nBúsqueda paralela por subárboles (hasta %d hilos, media de %d pasadas):\n", max_threads, rounds);
+    for (int i = 0; i < count; i++) {
+        if (!xpath_plan_parallel(plans[i])) {
+            printf("\n%s: no admite evaluación paralela, se omite\n", plans[i]->source);
+            continue;
+        }
+
+        // La primera ejecución construye los índices
+        free_xpath_result(xpath_execute(plans[i], doc));
+        double start = xml_time_now();
+        XPathResult *expected = xpath_execute(plans[i], doc);
+        double indexed = xml_time_now() - start;
+        printf("\n%s: %d resultado(s), %.3f ms con índices\n", plans[i]->source, expected->count, indexed * 1000.0);
+        printf("  Hilos   Tiempo (ms)   Aceleración   Eficiencia\n");
+
+        double base = 0;
+        for (int threads = 1; ; threads *= 2) {
+            if (threads > max_threads) threads = max_threads;
+            ThreadPool *pool = thread_pool_create(threads);
+            int same = 1;
+            start = xml_time_now();
+            for (int round = 0; round < rounds; round++) {
+                XPathResult *result = xpath_execute_parallel(plans[i], doc, pool);
+                same &= result->count == expected->count &&
+                        (result->count == 0 ||
+                         memcmp(result->nodes, expected->nodes, result->count * sizeof(XMLNode*)) == 0);
+                free_xpath_result(result);
+            }
+            double elapsed = (xml_time_now() - start) / rounds;
+            thread_pool_destroy(pool);
+
+            if (threads == 1) base = elapsed;
+            printf("  %5d  %12.3f  %10.2fx  %10.0f%%  %s\n", threads, elapsed * 1000.0, base / elapsed,
+                   base / elapsed / threads * 100.0, same ? "✓" : "✗ resultado distinto");
+            ok &= same;
+            if (threads == max_threads) break;
+        }
+        free_xpath_result(expected);
+    }
+    return ok ? 0 : 1;
+}
+
+// Evaluación conjunta de las primeras 1, 2, 4, ... consultas en un solo
+// recorrido frente a ejecutarlas una a una, con los índices por construir
+// (como en un documento recién analizado) y ya construidos. Cada resultado se
+// verifica contra el de xpath_execute (--shared-bench)
+static int run_shared_benchmark(XMLDocument *doc, XPathPlan **plans, int count) {
+    const int rounds = 3;
+    int ok = 1;
+
+    XPathResult **expected = (XPathResult**)malloc((count ? count : 1) * sizeof(XPathResult*));
+    XPathResult **results = (XPathResult**)malloc((count ? count : 1) * sizeof(XPathResult*));
+    for (int i = 0; i < count; i++) {
+        expected[i] = xpath_execute(plans[i], doc);
+    }
+
+    printf("\nEvaluación conjunta en un recorrido (media de %d pasadas):\n", rounds);
+    printf("  Consultas  Estados   Conjunto (ms)   Una a una (ms)   Con índices (ms)\n");
+    for (int n = 1; count > 0; n *= 2) {
+        if (n > count) n = count;
+        QuerySet *set = query_set_compile(plans, n);
+
+        int same = 1;
+        double start = xml_time_now();
+        for (int round = 0; round < rounds; round++) {
+            query_set_execute(set, doc, results);
+            for (int i = 0; i < n; i++) {
+                same &= results[i]->count == expected[i]->count &&
+                        (results[i]->count == 0 ||
+                         memcmp(results[i]->nodes, expected[i]->nodes, results[i]->count * sizeof(XMLNode*)) == 0);
+                free_xpath_result(results[i]);
+            }
+        }
+        double shared = (xml_time_now() - start) / rounds;
+
+        // Una a una: cada pasada invalida los índices, que se construyen
+        // otra vez en las consultas que los usan
+        double cold = 0;
+        for (int round = 0; round < rounds; round++) {
+            xml_document_changed(doc);
+            start = xml_time_now();
+            for (int i = 0; i < n; i++) {
+                free_xpath_result(xpath_execute(plans[i], doc));
+            }
+            cold += xml_time_now() - start;
+        }
+        cold /= rounds;
+
+        start = xml_time_now();
+        for (int round = 0; round < rounds; round++) {
+            for (int i = 0; i < n; i++) {
+                free_xpath_result(xpath_execute(plans[i], doc));
+            }
+        }
+        double warm = (xml_time_now() - start) / rounds;
+
+        printf("  %9d  %7d  %14.3f  %15.3f  %17.3f  %s\n", n, set->state_count, shared * 1000.0,
+               cold * 1000.0, warm * 1000.0, same ? "✓" : "✗ resultado distinto");
+        ok &= same;
+        free_query_set(set);
+        if (n == count) break;
+    }
+
+    for (int i = 0; i < count; i++) {
+        free_xpath_result(expected[i]);
+    }
+    free(expected);
+    free(results);
+    return ok ? 0 : 1;
+}
+
+// Documento de las comprobaciones: nombres repetidos a varias profundidades,
+// atributos con valores comunes (y repetidos en un mismo elemento), textos con
+// y sin los valores buscados y CDATA
+static const char *test_document =
+    "<lib id=\"r\">"
+    "<libro id=\"1\" genero=\"ficcion\"><titulo>Don Quijote de la Mancha</titulo>"
+    "<nota><![CDATA[texto <raro> con Quijote]]></nota>"
+    "<libro id=\"2\"><titulo>Quijotes modernos</titulo><libro id=\"3\"/></libro></libro>"
+    "<libro id=\"4\" genero=\"terror\"><titulo>Dracula</titulo><autor>Bram Stoker</autor>"
+    "<resumen>Un caballero, la mancha y más</resumen></libro>"
+    "<estante><libro id=\"5\" k=\"v\"><titulo>abc abcabc</titulo></libro>"
+    "<c>ñandú café</c><c k=\"v\">[abc]</c><c>ab</c></estante>"
+    "<a id=\"x\"/><b id=\"x\"/><a/><a><a id=\"y\"><b>xabc abc</b></a></a>"
+    "<b x=\"1\" x=\"1\"/><b x=\"1\"/><a><c y=\"2\" y=\"2\">abc abc</c></a>"
+    "</lib>";
+
+static const char *test_queries[] = {
+    "/lib", "/lib/*", "//*", "/*", "libro", "//libro", "//libro/titulo", "//libro//titulo",
+    "/lib/libro/titulo", "//libro/libro", "//libro//libro", "//a//a", "//a/a", "//nada",
+    "//libro[1]", "//libro[2]", "//libro[last()]", "//libro[last()]/titulo", "/lib/*[3]",
+    "//*[last()]", "//estante/c[2]", "//c[last()]", "//libro[0]",
+    "//libro[@id]", "//libro[@id='2']", "//libro[@id='2']/titulo", "//*[@id='x']",
+    "//*[@k='v']", "//*[@k]", "libro[@genero='terror']", "//a[@id='x']", "//c[@k='nada']",
+    "//*[contains(text(),'Quijote')]", "//titulo[contains(text(),'Quijote')]",
+    "//*[contains-token(text(),'Quijote')]", "//*[contains-token(text(),'abc')]",
+    "//*[contains(text(),'abc')]", "//*[contains(text(),'ab')]", "//*[contains(text(),'')]",
+    "//*[contains-token(text(),'café')]", "//libro/*[contains(text(),'mancha')]",
+    "//libro[@id='1']/titulo[contains(text(),'Don')]", "//*[contains(text(),'zzz')]",
+    "//titulo/text()", "//libro[@id='1']//*[@id]",
+    "b[@x='1']", "//b[@x='1']", "//c[@y=\"2\"]", "//a/c[@y='2']",
+};
+
+// Comparar dos resultados nodo a nodo
+static int same_result(const XPathResult *a, const XPathResult *b) {
+    return a->count == b->count &&
+           (a->count == 0 || memcmp(a->nodes, b->nodes, a->count * sizeof(XMLNode*)) == 0);
+}
+
+// Todos los nodos de un cursor, abierto con los índices en su estado actual
+static XPathResult* cursor_result(const XPathPlan *plan, XMLDocument *doc) {
+    XPathResult *result = init_xpath_result();
+    XPathCursor *cursor = xpath_cursor_open(plan, doc);
+    XMLNode *node;
+    while ((node = xpath_cursor_next(cursor))) {
+        add_to_result(result, node);
+    }
+    xpath_cursor_close(cursor);
+    return result;
+}
+
+// Comprobar cada vía de consulta contra xpath_execute: cursores con los
+// índices por construir y construidos, primer nodo, exists y LIMIT, árbol
+// compacto, evaluación paralela, caché de resultados (fallo y acierto) y el
+// conjunto de todas las consultas en un recorrido
+static int run_comparison_tests(XMLDocument *doc, XPathPlan **plans, int count) {
+    int failed = 0;
+    CompactTree tree;
+    QueryCache cache;
+    ThreadPool *pool = thread_pool_create(4);
+    XPathResult **set_results = (XPathResult**)malloc((count ? count : 1) * sizeof(XPathResult*));
+
+    QuerySet *set = query_set_compile(plans, count);
+    query_set_execute(set, doc, set_results);
+    compact_tree_build(&tree, doc);
+    init_query_cache(&cache, QUERY_CACHE_DEFAULT_BYTES);
+
+    for (int i = 0; i < count; i++) {
+        const XPathPlan *plan = plans[i];
+        char failures[256] = "";
+
+        // Sin índices el cursor recorre el árbol
+        xml_document_changed(doc);
+        XPathResult *cold = cursor_result(plan, doc);
+        XPathResult *expected = xpath_execute(plan, doc);
+        if (!same_result(cold, expected)) strcat(failures, " cursor");
+
+        XPathResult *warm = cursor_result(plan, doc);
+        if (!same_result(warm, expected)) strcat(failures, " cursor-índices");
+
+        XMLNode *first = xpath_first(plan, doc);
+        if (first != (expected->count ? expected->nodes[0] : NULL)) strcat(failures, " first");
+        if (xpath_exists(plan, doc) != (expected->count > 0)) strcat(failures, " exists");
+
+        XPathResult *limited = xpath_execute_limit(plan, doc, 2);
+        if (limited->count != (expected->count < 2 ? expected->count : 2) ||
+            (limited->count > 0 && memcmp(limited->nodes, expected->nodes, limited->count * sizeof(XMLNode*)) != 0)) {
+            strcat(failures, " limit");
+        }
+
+        // El árbol compacto numera los nodos en el mismo preorden
+        xml_number_nodes(doc);
+        CompactResult *compact = xpath_execute_compact(plan, &tree);
+        int same = compact->count == expected->count;
+        for (int j = 0; same && j < compact->count; j++) {
+            same = compact->nodes[j] == expected->nodes[j]->pre;
+        }
+        if (!same) strcat(failures, " compacto");
+
+        XPathResult *parallel = xpath_execute_parallel(plan, doc, pool);
+        if (!same_result(parallel, expected)) strcat(failures, " paralelo");
+
+        XPathResult *miss = query_cache_execute(&cache, plan, doc);
+        XPathResult *hit = query_cache_execute(&cache, plan, doc);
+        if (!same_result(miss, expected) || !same_result(hit, expected)) strcat(failures, " caché");
+
+        if (!same_result(set_results[i], expected)) strcat(failures, " conjunto");
+
+        printf("  %s %-48s %6d%s%s\n", failures[0] ? "✗" : "✓", plan->source, expected->count,
+               failures[0] ? "  difiere:" : "", failures);
+        failed += failures[0] != '\0';
+
+        free_xpath_result(cold);
+        free_xpath_result(warm);
+        free_xpath_result(limited);
+        free_compact_result(compact);
+        free_xpath_result(parallel);
+        free_xpath_result(miss);
+        free_xpath_result(hit);
+        free_xpath_result(set_results[i]);
+        free_xpath_result(expected);
+    }
+
+    free_query_cache(&cache);
+    free_compact_tree(&tree);
+    free_query_set(set);
+    free(set_results);
+    thread_pool_destroy(pool);
+    printf("%d de %d consultas con resultados idénticos en todas las vías\n", count - failed, count);
+    return failed == 0;
+}
+
+// Analizar un documento en memoria a través de un archivo temporal
+static int parse_test_document(XMLParseContext *ctx, const char *xml) {
+    FILE *file = tmpfile();
+    if (!file) {
+        perror("Error al crear el archivo temporal");
+        return 0;
+    }
+    fputs(xml, file);
+    rewind(file);
+    ctx->input.file = file;
+    return parse_xml_input(ctx) == 1;
+}
+
+// Un documento nuevo con tantos nodos como el anterior, analizado en la
+// misma estructura, tiene su dirección y su versión: la caché no debe
+// devolver los nodos del documento liberado
+static int run_cache_reuse_test(void) {
+    XMLParseContext ctx;
+    QueryCache cache;
+    XPathPlan *plan = xpath_compile("//libro");
+    init_query_cache(&cache, QUERY_CACHE_DEFAULT_BYTES);
+
+    init_parse_context(&ctx);
+    ctx.verbose = 0;
+    int ok = parse_test_document(&ctx, "<lib><libro/><libro/></lib>");
+    free_xpath_result(query_cache_execute(&cache, plan, &ctx.document));
+    free_parse_context(&ctx);
+
+    init_parse_context(&ctx);
+    ctx.verbose = 0;
+    ok &= parse_test_document(&ctx, "<lib><libro/><otro/></lib>");
+    XPathResult *cached = query_cache_execute(&cache, plan, &ctx.document);
+    XPathResult *expected = xpath_execute(plan, &ctx.document);
+    ok &= same_result(cached, expected);
+    printf("  %s Caché con un documento nuevo en el mismo contexto: %d nodo(s)\n", ok ? "✓" : "✗", cached->count);
+
+    free_xpath_result(cached);
+    free_xpath_result(expected);
+    free_parse_context(&ctx);
+    free_query_cache(&cache);
+    free_xpath_plan(plan);
+    return ok;
+}
+
+// Comprobaciones con el documento y las consultas de prueba, o con los de
+// los argumentos, y recorridos de árboles profundos y anchos (--test)
+static int run_tests(XMLParseContext *ctx, const char *path, XPathPlan **plans, int count) {
+    ctx->verbose = 0;
+    int parsed = path ? parse_xml_file(ctx, path) == 1 : parse_test_document(ctx, test_document);
+    if (!parsed) {
+        printf("✗ Error al analizar el documento de prueba\n");
+        return 1;
+    }
+
+    int ok;
+    printf("Consultas comparadas con xpath_execute:\n");
+    if (plans) {
+        ok = run_comparison_tests(&ctx->document, plans, count);
+    } else {
+        count = (int)(sizeof(test_queries) / sizeof(test_queries[0]));
+        plans = (XPathPlan**)malloc(count * sizeof(XPathPlan*));
+        for (int i = 0; i < count; i++) {
+            plans[i] = xpath_compile(test_queries[i]);
+        }
+        ok = run_comparison_tests(&ctx->document, plans, count);
+        free_xpath_plans(plans, count);
+    }
+    ok &= run_cache_reuse_test();
+
+    printf("\n");
+    ok &= run_stress_test(10000) == 0;
+    return ok ? 0 : 1;
+}
+
+// Analizar el documento de un benchmark sin imprimir el análisis
+static int parse_bench_document(XMLParseContext *ctx, const char *path) {
+    ctx->verbose = 0;
+    int status = parse_xml_file(ctx, path);
+    if (status < 0) {
+        perror("Error al abrir el archivo");
+        return 0;
+    }
+    if (status == 0) {
+        printf("✗ Error en el análisis del archivo XML\n");
+        return 0;
+    }
+    printf("Documento %s: %d elementos (análisis %.3f ms)\n", path,
+           count_elements(ctx->document.root), ctx->parse_time * 1000.0);
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = NULL;
+    int allow_mmap = 1;
+    int allow_simd = 1;
+    int test = 0;
+    int lex_bench = 0;
+    int compact_bench = 0;
+    int parallel_bench = 0;
+    int shared_bench = 0;
+    int threads = 0;
+    const char *query_file = NULL;
+    long wide_bench = 0;
+    long stress = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-mmap") == 0) {
+            allow_mmap = 0;
+        } else if (strcmp(argv[i], "--no-simd") == 0) {
+            allow_simd = 0;
+        } else if (strcmp(argv[i], "--test") == 0) {
+            test = 1;
+        } else if (strcmp(argv[i], "--lex-bench") == 0) {
+            lex_bench = 1;
+        } else if (strcmp(argv[i], "--compact-bench") == 0) {
+            compact_bench = 1;
+        } else if (strcmp(argv[i], "--parallel-bench") == 0) {
+            parallel_bench = 1;
+        } else if (strcmp(argv[i], "--shared-bench") == 0) {
+            shared_bench = 1;
+        } else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) {
+            query_file = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--stress") == 0 && i + 1 < argc) {
+            stress = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--wide-bench") == 0 && i + 1 < argc) {
+            wide_bench = atol(argv[++i]);
+        } else if (!path) {
+            path = argv[i];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+
+    int needs_document = lex_bench || compact_bench || parallel_bench || shared_bench;
+    int needs_queries = parallel_bench || shared_bench;
+    if ((!test && wide_bench <= 0 && stress <= 0 && !needs_document) || (needs_document && !path) ||
+        (needs_queries && !query_file) || (test && (query_file != NULL) != (path != NULL))) {
+        fprintf(stderr, "Uso: %s --test [--queries <archivo> <archivo.xml>]\n", argv[0]);
+        fprintf(stderr, "     %s --stress <nodos> | --wide-bench <hijos>\n", argv[0]);
+        fprintf(stderr, "     %s [--no-mmap] [--no-simd] --lex-bench | --compact-bench <archivo.xml>\n", argv[0]);
+        fprintf(stderr, "     %s --queries <archivo> --parallel-bench [-j N] | --shared-bench <archivo.xml>\n", argv[0]);
+        return 1;
+    }
+
+    scan_init(allow_simd);
+
+    if (wide_bench > 0) {
+        return run_wide_benchmark(wide_bench);
+    }
+    if (stress > 0) {
+        return run_stress_test(stress);
+    }
+
+    int count = 0;
+    double compile_seconds = 0;
+    XPathPlan **plans = NULL;
+    if (query_file) {
+        plans = xpath_load_plans(query_file, &count, &compile_seconds);
+        if (!plans) {
+            perror("Error al abrir el archivo de consultas");
+            return 1;
+        }
+    }
+
+    int result = 1;
+    XMLParseContext ctx;
+    init_parse_context(&ctx);
+    ctx.use_mmap = allow_mmap;
+    ctx.fast_path = allow_simd;
+
+    if (test) {
+        result = run_tests(&ctx, path, plans, count);
+    } else if (lex_bench) {
+        result = run_lexer_benchmark(&ctx, path);
+    } else if (parse_bench_document(&ctx, path)) {
+        if (compact_bench) {
+            result = run_compact_benchmark(&ctx.document);
+        } else if (parallel_bench) {
+            result = run_parallel_benchmark(&ctx.document, plans, count,
+                                            threads > 0 ? threads : thread_pool_default_threads());
+        } else {
+            result = run_shared_benchmark(&ctx.document, plans, count);
+        }
+    }
+
+    free_parse_context(&ctx);
+    free_xpath_plans(plans, count);
+    return result;
+}
@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "xml_parser.h"
+#include "simd_scan.h"
+#include "batch.h"
+#include "xml_push.h"
+#include "xpath_engine.h"
+#include "query_cache.h"
+
+// Ejecutar consultas ya compiladas sobre el documento y mostrar por separado
+// el tiempo de compilación y el de ejecución (--queries)
+static void run_query_plans(XMLDocument *doc, XPathPlan **plans, int count, double compile_seconds,
+                            QueryCache *cache) {
+    const int rounds = 10;
+    double execute_seconds = 0;
+
+    printf("\nConsultas compiladas: %d (compilación %.3f ms, %.2f µs/consulta)\n",
+           count, compile_seconds * 1000.0, count ? compile_seconds * 1e6 / count : 0.0);
+    printf("  Resultados   Ejecución (µs)   Primer nodo (µs)   Consulta\n");
+    for (int i = 0; i < count; i++) {
+        int matches = 0;
+        double start = xml_time_now();
+        for (int round = 0; round < rounds; round++) {
+            XPathResult *result = cache ? query_cache_execute(cache, plans[i], doc) : xpath_execute(plans[i], doc);
+            matches = result->count;
+            free_xpath_result(result);
+        }
+        double elapsed = (xml_time_now() - start) / rounds;
+        execute_seconds += elapsed;
+
+        // Con un cursor solo se produce el primer nodo
+        start = xml_time_now();
+        for (int round = 0; round < rounds; round++) {
+            xpath_first(plans[i], doc);
+        }
+        double first = (xml_time_now() - start) / rounds;
+        printf("  %10d   %14.2f   %16.2f   %s\n", matches, elapsed * 1e6, first * 1e6, plans[i]->source);
+    }
+    printf("Ejecución: %.3f ms por pasada de las %d consultas (media de %d pasadas)\n",
+           execute_seconds * 1000.0, count, rounds);
+    printf("Índice de nombres: %zu KB (%zu elementos, %u nombres)\n",
+           xml_element_index_memory(doc) / 1024, doc->element_index.node_count, doc->element_index.name_count);
+    printf("Índice de atributos: %zu KB (%zu por nombre, %zu por par nombre-valor)\n",
+           xml_attribute_index_memory(doc) / 1024, doc->attribute_index.name_node_count,
+           doc->attribute_index.value_node_count);
+    printf("Resumen de caminos: %zu KB (%u caminos)\n",
+           xml_path_summary_memory(doc) / 1024, doc->path_summary.path_count);
+    printf("Índice de texto: %zu KB (%u nodos de texto, %u trigramas)\n",
+           xml_text_index_memory(doc) / 1024, doc->text_index.text_count, doc->text_index.trigram_count);
+    if (cache) {
+        print_query_cache_stats(cache);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = NULL;
+    int allow_mmap = 1;
+    int allow_simd = 1;
+    int stream = 0;
+    int paths = 0;
+    int text_index = 0;
+    int explain = 0;
+    const char *query_file = NULL;
+    long cache_kb = -1;  // -1 = sin --cache-kb (0 desactiva la caché)
+    long push_chunk = 0;
+    const char *batch_dir = NULL;
+    BatchOptions batch = { 0, 1, 1, 0, NULL, 0 };
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-mmap") == 0) {
+            allow_mmap = 0;
+        } else if (strcmp(argv[i], "--no-simd") == 0) {
+            allow_simd = 0;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            stream = 1;
+        } else if (strcmp(argv[i], "--paths") == 0) {
+            paths = 1;
+        } else if (strcmp(argv[i], "--text-index") == 0) {
+            text_index = 1;
+        } else if (strcmp(argv[i], "--explain") == 0) {
+            explain = 1;
+        } else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) {
+            query_file = argv[++i];
+        } else if (strcmp(argv[i], "--cache-kb") == 0 && i + 1 < argc) {
+            cache_kb = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--push") == 0 && i + 1 < argc) {
+            push_chunk = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_dir = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            batch.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scaling") == 0) {
+            batch.scaling = 1;
+        } else if (!path) {
+            path = argv[i];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+
+    if (!path && !batch_dir) {
+        fprintf(stderr, "Uso: %s [--no-mmap] [--no-simd] [--stream] [--push N] [--paths] [--text-index] [--cache-kb N] [--queries <archivo> [--explain]] <archivo.xml | ->\n", argv[0]);
+        fprintf(stderr, "     %s --batch <directorio> [-j N] [--scaling] [--queries <archivo>] [--no-mmap] [--no-simd]\n", argv[0]);
+        return 1;
+    }
+
+    // Selección de la implementación vectorizada: una vez, antes de analizar
+    scan_init(allow_simd);
+
+    // Las consultas se compilan una sola vez para todos los documentos
+    double compile_seconds = 0;
+    if (query_file) {
+        batch.plans = xpath_load_plans(query_file, &batch.plan_count, &compile_seconds);
+        if (!batch.plans) {
+            perror("Error al abrir el archivo de consultas");
+            return 1;
+        }
+    }
+
+    if (batch_dir) {
+        batch.use_mmap = allow_mmap;
+        batch.fast_path = allow_simd;
+        if (query_file) {
+            printf("Consultas compiladas: %d (%.3f ms)\n", batch.plan_count, compile_seconds * 1000.0);
+        }
+        int errors = run_batch(batch_dir, &batch);
+        free_xpath_plans(batch.plans, batch.plan_count);
+        return errors == 0 ? 0 : 1;
+    }
+
+    XMLParseContext ctx;
+    init_parse_context(&ctx);
+    ctx.use_mmap = allow_mmap;
+    ctx.fast_path = allow_simd;
+
+    // Modo por eventos: análisis semántico sin construir el árbol
+    if (stream) {
+        ctx.sax = &semantic_sax_handler;
+        ctx.sax_data = &ctx.semantic_table;
+    }
+
+    printf("Analizando archivo XML: %s\n", path);
+    
+    int status = push_chunk > 0 ? push_parse_file(&ctx, path, (size_t)push_chunk)
+                                : parse_xml_file(&ctx, path);
+    if (status < 0) {
+        perror("Error al abrir el archivo");
+        return 1;
+    }
+
+    if (status && stream) {
+        printf("✓ Análisis exitoso del archivo XML (modo por eventos, sin árbol)\n");
+        print_semantic_table(&ctx.semantic_table);
+        
+        printf("Estadísticas del documento:\n");
+        printf("- Bytes analizados: %zu (%s)\n", ctx.bytes_read, ctx.input_mapped ? "mmap" : "flujo");
+        printf("- Memoria máxima del documento: %zu KB\n", ctx.peak_memory / 1024);
+        if (ctx.parse_time > 0) {
+            printf("- Velocidad de análisis: %.2f MB/s (%.3f ms)\n",
+                   ctx.bytes_read / ctx.parse_time / (1024.0 * 1024.0), ctx.parse_time * 1000.0);
+        }
+    } else if (status) {
+        XMLDocument *document = &ctx.document;
+        printf("✓ Análisis exitoso del archivo XML\n");
+        printf("✓ Estructura XML válida\n");
+        
+        // Mostrar estadísticas
+        printf("\nEstadísticas del documento:\n");
+        printf("- Elementos: %d\n", count_elements(document->root));
+        printf("- Atributos: %d\n", count_attributes(document->root));
+        printf("- Bytes analizados: %zu (%s)\n", ctx.bytes_read, ctx.input_mapped ? "mmap" : "flujo");
+        printf("- Escáner: %s\n", ctx.input_mapped && ctx.fast_path ? scan_backend_name() : "DFA de flex");
+        printf("- Memoria del documento: %zu KB (nombres %zu KB para %u distintos, cadenas %zu KB, "
+               "nodos %zu KB, atributos %zu KB)\n",
+               xml_document_memory(document) / 1024,
+               symbol_table_memory(&document->names) / 1024, document->names.count,
+               document->strings.bytes_reserved / 1024, document->nodes.bytes_reserved / 1024,
+               (document->attributes.bytes_reserved + document->attribute_lists.bytes_reserved) / 1024);
+        if (ctx.parse_time > 0) {
+            printf("- Velocidad de análisis: %.2f MB/s (%.3f ms)\n",
+                   ctx.bytes_read / ctx.parse_time / (1024.0 * 1024.0), ctx.parse_time * 1000.0);
+        }
+        
+        if (paths) {
+            print_path_summary(document);
+        }
+        
+        // Índice de texto para contains(): se construye ahora en lugar de en
+        // la primera consulta que lo usa
+        if (text_index) {
+            xml_text_index_build(document);
+            TextIndex *index = &document->text_index;
+            printf("- Índice de texto: %u nodos de texto (%zu KB), %u trigramas, %zu KB, %.3f ms\n",
+                   index->text_count, index->text_bytes / 1024, index->trigram_count,
+                   xml_text_index_memory(document) / 1024, index->build_seconds * 1000.0);
+        }
+        
+        if (query_file && explain) {
+            // Plan de cada consulta, ejecutada paso a paso
+            for (int i = 0; i < batch.plan_count; i++) {
+                printf("\n");
+                print_xpath_explain(batch.plans[i], document);
+            }
+        } else if (query_file && cache_kb >= 0) {
+            QueryCache cache;
+            init_query_cache(&cache, (size_t)cache_kb * 1024);
+            run_query_plans(document, batch.plans, batch.plan_count, compile_seconds, &cache);
+            free_query_cache(&cache);
+        } else if (query_file) {
+            run_query_plans(document, batch.plans, batch.plan_count, compile_seconds, NULL);
+        } else {
+            // Modo interactivo para consultas XPath, con caché de resultados
+            xpath_interactive_mode(document, cache_kb >= 0 ? (size_t)cache_kb * 1024 : QUERY_CACHE_DEFAULT_BYTES);
+        }
+        
+    } else {
+        printf("✗ Error en el análisis del archivo XML\n");
+        free_parse_context(&ctx);
+        free_xpath_plans(batch.plans, batch.plan_count);
+        return 1;
+    }
+
+    free_parse_context(&ctx);
+    free_xpath_plans(batch.plans, batch.plan_count);
+    
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef XML_INPUT_H
+#define XML_INPUT_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// Fuente de entrada para el analizador léxico
+typedef struct XMLInput {
+    FILE *file;           // Modo flujo: se entrega a flex mediante yyin
+    char *buffer;         // Modo mapeado: contenido seguido de dos bytes nulos
+    size_t size;          // Tamaño del documento en bytes (0 si se desconoce)
+    size_t mapped_size;   // Tamaño total de la región mapeada
+    int mapped;           // 1 si el archivo está mapeado en memoria
+} XMLInput;
+
+// Abrir la entrada; usa mmap para archivos regulares si allow_mmap != 0
+// y recurre a fopen para tuberías, stdin ("-") o sistemas sin mmap
+int xml_input_open(XMLInput *input, const char *path, int allow_mmap);
+void xml_input_close(XMLInput *input);
+
+// Reloj monótono en segundos para mediciones de rendimiento
+double xml_time_now(void);
+
+#endif
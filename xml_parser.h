@@ -0,0 +1,56 @@
+#ifndef XML_PARSER_H
+#define XML_PARSER_H
+
+#include "xml_tree.h"
+#include "semantic_analyzer.h"
+#include "xml_input.h"
+#include "xml_sax.h"
+
+// Contexto de análisis: todo el estado de un documento, sin variables
+// globales, para poder analizar varios documentos en hilos distintos
+typedef struct XMLParseContext {
+    XMLDocument document;
+    SemanticTable semantic_table;
+    int parse_success;
+
+    // Opciones
+    int use_mmap;              // Mapear archivos regulares en memoria
+    int fast_path;             // Usar la vía vectorizada del lexer
+    int verbose;               // Imprimir el progreso y la tabla semántica
+
+    // Modo por eventos: si sax != NULL no se construye el árbol
+    const XMLSaxHandler *sax;
+    void *sax_data;            // Primer argumento de las funciones de sax
+    size_t peak_memory;        // Máximo de memoria del documento entre eventos
+
+    // Entrada y mediciones
+    XMLInput input;
+    size_t bytes_read;         // Bytes analizados
+    int input_mapped;          // La entrada se analizó mapeada en memoria
+    double parse_time;         // Segundos en yyparse
+
+    // Estado del analizador léxico (yyscan_t de flex)
+    void *scanner;
+    int column;
+    int fast_active;           // Vía rápida activa para el buffer actual
+    const char *memory_end;    // Fin del documento en memoria
+} XMLParseContext;
+
+// Funciones del contexto
+void init_parse_context(XMLParseContext *ctx);
+void free_parse_context(XMLParseContext *ctx);
+
+// Analizar un archivo ("-" para stdin) y construir su árbol y tabla semántica.
+// Devuelve 1 si el documento es válido, 0 si hay errores y -1 si no se pudo abrir
+int parse_xml_file(XMLParseContext *ctx, const char *path);
+// Igual que parse_xml_file sobre ctx->input ya abierta (por ejemplo, un
+// archivo temporal); la entrada se cierra al terminar
+int parse_xml_input(XMLParseContext *ctx);
+
+// Funciones del analizador léxico (lexer.l) sobre ctx->input ya abierto
+// o, si no hay entrada, sobre los fragmentos entregados en modo push
+int lexer_init(XMLParseContext *ctx);
+int lexer_scan_chunk(XMLParseContext *ctx, const char *data, size_t len);
+void lexer_destroy(XMLParseContext *ctx);
+
+#endif
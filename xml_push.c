@@ -0,0 +1,251 @@
+#include "xml_push.h"
+#include "parser.tab.h"
+#include "simd_scan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int yylex(YYSTYPE *yylval_param, void *yyscanner);
+
+// Contexto léxico del delimitador de fragmentos: solo se corta antes de un
+// '<' en estado de contenido, nunca dentro de tags, comillas o comentarios
+enum {
+    PUSH_CONTENT,
+    PUSH_TAG,
+    PUSH_DOUBLE_QUOTE,
+    PUSH_SINGLE_QUOTE,
+    PUSH_COMMENT,
+    PUSH_CDATA,
+    PUSH_PI
+};
+
+// Construcciones que empiezan con '<' y terminan con su propio delimitador
+static const struct {
+    const char *open;
+    const char *close;
+    int state;
+} markups[] = {
+    { "<!--", "-->", PUSH_COMMENT },
+    { "<![CDATA[", "]]>", PUSH_CDATA },
+    { "<?", "?>", PUSH_PI }
+};
+
+#define MARKUP_COUNT (sizeof(markups) / sizeof(markups[0]))
+
+// Clasificar la construcción que empieza en '<'; devuelve -1 si faltan bytes
+static int classify_markup(const char **pos, const char *end) {
+    const char *p = *pos;
+    size_t avail = end - p;
+
+    for (size_t i = 0; i < MARKUP_COUNT; i++) {
+        size_t len = strlen(markups[i].open);
+        size_t n = avail < len ? avail : len;
+        if (memcmp(p, markups[i].open, n) == 0) {
+            if (avail < len) return -1;
+            *pos = p + len;
+            return markups[i].state;
+        }
+    }
+
+    *pos = p + 1;
+    return PUSH_TAG;
+}
+
+// Buscar el delimitador de cierre de un comentario, CDATA o instrucción
+static const char* find_close(int state, const char *p, const char *end) {
+    if (state == PUSH_COMMENT) {
+        return scan_find_comment_end(p, end);
+    }
+
+    const char *close = state == PUSH_CDATA ? "]]>" : "?>";
+    size_t len = strlen(close);
+    while ((p = scan_find_char(p, end, close[0])) < end) {
+        if ((size_t)(end - p) >= len && memcmp(p, close, len) == 0) {
+            return p;
+        }
+        p++;
+    }
+    return end;
+}
+
+static size_t close_length(int state) {
+    for (size_t i = 0; i < MARKUP_COUNT; i++) {
+        if (markups[i].state == state) return strlen(markups[i].close);
+    }
+    return 1;
+}
+
+// Avanzar el delimitador sobre los bytes nuevos y devolver la longitud del
+// prefijo que forma tokens completos (hasta el último '<' en contenido)
+static size_t find_cut(XMLPushParser *parser) {
+    const char *data = parser->pending;
+    const char *end = data + parser->pending_used;
+    const char *p = data + parser->scanned;
+    size_t cut = 0;
+
+    while (p < end) {
+        int state = parser->scan_state;
+
+        if (state == PUSH_CONTENT) {
+            p = scan_find_char(p, end, '<');
+            if (p == end) break;
+            cut = p - data;
+            int next = classify_markup(&p, end);
+            if (next < 0) break;  // Prefijo incompleto: se reclasifica con más datos
+            parser->scan_state = next;
+        } else if (state == PUSH_TAG) {
+            while (p < end && *p != '>' && *p != '"' && *p != '\'') p++;
+            if (p == end) break;
+            parser->scan_state = *p == '>' ? PUSH_CONTENT :
+                                 (*p == '"' ? PUSH_DOUBLE_QUOTE : PUSH_SINGLE_QUOTE);
+            p++;
+        } else if (state == PUSH_DOUBLE_QUOTE || state == PUSH_SINGLE_QUOTE) {
+            p = scan_find_char(p, end, state == PUSH_DOUBLE_QUOTE ? '"' : '\'');
+            if (p == end) break;
+            parser->scan_state = PUSH_TAG;
+            p++;
+        } else {
+            size_t len = close_length(state);
+            const char *stop = find_close(state, p, end);
+            if (stop == end) {
+                // El delimitador puede quedar partido entre dos fragmentos
+                if ((size_t)(end - p) >= len) p = end - (len - 1);
+                break;
+            }
+            parser->scan_state = PUSH_CONTENT;
+            p = stop + len;
+        }
+    }
+
+    parser->scanned = p - data;
+    return cut;
+}
+
+// Analizar un tramo completo: cada token se entrega al parser push
+static int parse_segment(XMLPushParser *parser, const char *data, size_t len) {
+    XMLParseContext *ctx = parser->ctx;
+    YYSTYPE value;
+    int token;
+
+    if (!lexer_scan_chunk(ctx, data, len)) {
+        fprintf(stderr, "Error: no se pudo crear el buffer del analizador léxico\n");
+        parser->status = 1;
+        return 0;
+    }
+    while (parser->status == YYPUSH_MORE && (token = yylex(&value, ctx->scanner)) != 0) {
+        parser->status = yypush_parse((yypstate*)parser->state, token, &value, ctx->scanner, ctx);
+    }
+    return parser->status == YYPUSH_MORE;
+}
+
+// Preparar el análisis de un documento nuevo sobre ctx (sin entrada abierta)
+int init_push_parser(XMLPushParser *parser, XMLParseContext *ctx) {
+    parser->ctx = ctx;
+    parser->pending = NULL;
+    parser->pending_used = 0;
+    parser->pending_size = 0;
+    parser->scanned = 0;
+    parser->scan_state = PUSH_CONTENT;
+    parser->status = YYPUSH_MORE;
+
+    ctx->input_mapped = 0;
+    ctx->parse_time = 0;
+    if (!lexer_init(ctx)) {
+        return 0;
+    }
+    parser->state = yypstate_new();
+    if (!parser->state) {
+        lexer_destroy(ctx);
+        return 0;
+    }
+    return 1;
+}
+
+// Entregar un fragmento y analizar todos los tokens ya completos
+int push_parser_feed(XMLPushParser *parser, const char *data, size_t len) {
+    if (parser->status != YYPUSH_MORE) return 0;
+    double start = xml_time_now();
+
+    if (parser->pending_used + len > parser->pending_size) {
+        size_t size = parser->pending_size ? parser->pending_size : 4096;
+        while (size < parser->pending_used + len) size *= 2;
+        parser->pending = (char*)realloc(parser->pending, size);
+        parser->pending_size = size;
+    }
+    memcpy(parser->pending + parser->pending_used, data, len);
+    parser->pending_used += len;
+    parser->ctx->bytes_read += len;
+
+    size_t cut = find_cut(parser);
+    if (cut > 0) {
+        parse_segment(parser, parser->pending, cut);
+        memmove(parser->pending, parser->pending + cut, parser->pending_used - cut);
+        parser->pending_used -= cut;
+        parser->scanned -= cut;
+    }
+
+    parser->ctx->parse_time += xml_time_now() - start;
+    return parser->status == YYPUSH_MORE;
+}
+
+// Fin del documento: analizar lo pendiente y entregar el fin de entrada
+int push_parser_finish(XMLPushParser *parser) {
+    XMLParseContext *ctx = parser->ctx;
+    double start = xml_time_now();
+
+    if (parser->status == YYPUSH_MORE && parser->pending_used > 0) {
+        parse_segment(parser, parser->pending, parser->pending_used);
+        parser->pending_used = 0;
+        parser->scanned = 0;
+    }
+    if (parser->status == YYPUSH_MORE) {
+        parser->status = yypush_parse((yypstate*)parser->state, 0, NULL, ctx->scanner, ctx);
+    }
+
+    ctx->parse_time += xml_time_now() - start;
+    if (xml_document_memory(&ctx->document) > ctx->peak_memory) {
+        ctx->peak_memory = xml_document_memory(&ctx->document);
+    }
+    if (!ctx->sax && ctx->document.root) {
+        xml_number_nodes(&ctx->document);
+    }
+    return parser->status == 0 && ctx->parse_success;
+}
+
+void free_push_parser(XMLPushParser *parser) {
+    if (parser->state) {
+        yypstate_delete((yypstate*)parser->state);
+        parser->state = NULL;
+    }
+    lexer_destroy(parser->ctx);
+    free(parser->pending);
+    parser->pending = NULL;
+    parser->pending_used = 0;
+    parser->pending_size = 0;
+}
+
+// Analizar un archivo en bloques de 'chunk_size' bytes con el parser push
+int push_parse_file(XMLParseContext *ctx, const char *path, size_t chunk_size) {
+    XMLInput input;
+    if (!xml_input_open(&input, path, 0)) {
+        return -1;
+    }
+
+    XMLPushParser parser;
+    if (!init_push_parser(&parser, ctx)) {
+        xml_input_close(&input);
+        return -1;
+    }
+
+    char *chunk = (char*)malloc(chunk_size);
+    size_t n;
+    while ((n = fread(chunk, 1, chunk_size, input.file)) > 0) {
+        if (!push_parser_feed(&parser, chunk, n)) break;
+    }
+
+    int status = push_parser_finish(&parser);
+    free_push_parser(&parser);
+    free(chunk);
+    xml_input_close(&input);
+    return status;
+}
@@ -0,0 +1,36 @@
+#ifndef XML_PUSH_H
+#define XML_PUSH_H
+
+#include <stddef.h>
+#include "xml_parser.h"
+
+// Parser en modo push: el documento llega en fragmentos arbitrarios (tuberías,
+// sockets, mensajes) y se analiza a medida que llega. Los bytes se acumulan
+// hasta el último '<' en estado de contenido; todo lo anterior forma tokens
+// completos y se entrega al lexer y al parser, el resto espera al siguiente
+// fragmento. Con ctx->sax los eventos de los elementos completos se reciben
+// antes de que termine el documento.
+typedef struct XMLPushParser {
+    XMLParseContext *ctx;
+    void *state;            // yypstate de bison
+    char *pending;          // Bytes recibidos que aún no se analizaron
+    size_t pending_used;
+    size_t pending_size;
+    size_t scanned;         // Bytes de 'pending' ya clasificados
+    int scan_state;         // Contexto léxico en la posición 'scanned'
+    int status;             // Resultado de yypush_parse (YYPUSH_MORE mientras continúa)
+} XMLPushParser;
+
+// Preparar el análisis de un documento nuevo sobre ctx (sin entrada abierta)
+int init_push_parser(XMLPushParser *parser, XMLParseContext *ctx);
+// Entregar un fragmento; devuelve 0 si el documento ya tiene errores
+int push_parser_feed(XMLPushParser *parser, const char *data, size_t len);
+// Fin del documento: 1 si es válido, 0 si hay errores (como parse_xml_file)
+int push_parser_finish(XMLPushParser *parser);
+void free_push_parser(XMLPushParser *parser);
+
+// Analizar un archivo ("-" para stdin) leyéndolo en bloques de 'chunk_size'
+// bytes a través del parser push
+int push_parse_file(XMLParseContext *ctx, const char *path, size_t chunk_size);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef XML_SAX_H
+#define XML_SAX_H
+
+#include "xml_tree.h"
+
+// Interfaz de eventos (estilo SAX): el parser llama a estas funciones desde
+// las acciones de la gramática en lugar de construir el árbol XMLNode.
+// Las cadenas y atributos solo son válidos durante la llamada; cada función
+// devuelve distinto de cero para continuar o 0 para detener el análisis.
+// Cualquier función puede ser NULL si el consumidor no necesita el evento.
+// Los nombres están internados en la tabla de símbolos del documento y
+// siguen siendo válidos hasta liberarlo; name_id es su ID en esa tabla.
+typedef struct XMLSaxHandler {
+    int (*start_element)(void *user_data, const char *name, uint32_t name_id, const Attribute *attributes);
+    int (*end_element)(void *user_data, const char *name);
+    int (*text)(void *user_data, const char *text);
+    int (*cdata)(void *user_data, const char *data);
+} XMLSaxHandler;
+
+#endif
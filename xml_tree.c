@@ -1,16 +1,720 @@
 #include "xml_tree.h"
+#include "xml_input.h"
 #include <ctype.h>
 
+// Último identificador de documento asignado (compartido entre hilos)
+static unsigned long last_document_id = 0;
+
+// Inicializar documento vacío
+void init_xml_document(XMLDocument *doc) {
+    doc->root = NULL;
+    doc->id = __sync_add_and_fetch(&last_document_id, 1);
+    init_symbol_table(&doc->names);
+    arena_init(&doc->strings, ARENA_DEFAULT_CHUNK);
+    pool_init(&doc->nodes, sizeof(XMLNode), 4096);
+    pool_init(&doc->attributes, sizeof(Attribute), 4096);
+    pool_init(&doc->attribute_lists, sizeof(AttributeList), 1024);
+    doc->version = 0;
+    memset(&doc->element_index, 0, sizeof(ElementIndex));
+    memset(&doc->attribute_index, 0, sizeof(AttributeIndex));
+    memset(&doc->path_summary, 0, sizeof(PathSummary));
+    memset(&doc->text_index, 0, sizeof(TextIndex));
+    doc->numbering_version = 0;
+    doc->numbered = 0;
+    doc->statistics = NULL;
+    doc->statistics_version = 0;
+}
+
+// Liberar el documento completo: una liberación por bloque, sin recorrer el árbol
+void free_xml_document(XMLDocument *doc) {
+    pool_release(&doc->nodes);
+    pool_release(&doc->attributes);
+    pool_release(&doc->attribute_lists);
+    arena_release(&doc->strings);
+    free_symbol_table(&doc->names);
+    free(doc->element_index.offsets);
+    free(doc->element_index.nodes);
+    memset(&doc->element_index, 0, sizeof(ElementIndex));
+    free(doc->attribute_index.name_offsets);
+    free(doc->attribute_index.name_nodes);
+    free(doc->attribute_index.groups);
+    free(doc->attribute_index.slots);
+    free(doc->attribute_index.value_nodes);
+    memset(&doc->attribute_index, 0, sizeof(AttributeIndex));
+    free(doc->path_summary.paths);
+    free(doc->path_summary.slots);
+    free(doc->path_summary.nodes);
+    memset(&doc->path_summary, 0, sizeof(PathSummary));
+    free(doc->text_index.texts);
+    free(doc->text_index.trigrams);
+    free(doc->text_index.postings);
+    memset(&doc->text_index, 0, sizeof(TextIndex));
+    doc->numbered = 0;
+    doc->statistics = NULL;
+    doc->version++;
+    doc->root = NULL;
+}
+
+// Memoria reservada por el documento (nombres, cadenas, nodos y atributos)
+size_t xml_document_memory(XMLDocument *doc) {
+    return symbol_table_memory(&doc->names) + doc->strings.bytes_reserved + doc->nodes.bytes_reserved +
+           doc->attributes.bytes_reserved + doc->attribute_lists.bytes_reserved;
+}
+
+// Registrar una modificación del árbol: los índices se reconstruirán
+void xml_document_changed(XMLDocument *doc) {
+    doc->version++;
+}
+
+// Construir el índice de elementos por nombre con dos recorridos: contar
+// los nodos de cada nombre y luego colocarlos en orden de documento
+void xml_element_index_build(XMLDocument *doc) {
+    ElementIndex *index = &doc->element_index;
+    if (index->built && index->version == doc->version) {
+        return;
+    }
+    
+    uint32_t name_count = doc->names.count;
+    free(index->offsets);
+    free(index->nodes);
+    index->offsets = (uint32_t*)calloc(name_count + 1, sizeof(uint32_t));
+    index->name_count = name_count;
+    
+    XMLTreeWalker walker;
+    XMLNode *node;
+    size_t total = 0;
+    xml_walker_init_list(&walker, doc->root);
+    while ((node = xml_walker_next(&walker))) {
+        if (node->type == NODE_ELEMENT) {
+            index->offsets[node->name_id + 1]++;
+            total++;
+        }
+    }
+    for (uint32_t id = 0; id < name_count; id++) {
+        index->offsets[id + 1] += index->offsets[id];
+    }
+    
+    // Posición de inserción de cada nombre
+    uint32_t *next = (uint32_t*)malloc((name_count ? name_count : 1) * sizeof(uint32_t));
+    memcpy(next, index->offsets, name_count * sizeof(uint32_t));
+    index->nodes = (XMLNode**)malloc((total ? total : 1) * sizeof(XMLNode*));
+    xml_walker_init_list(&walker, doc->root);
+    while ((node = xml_walker_next(&walker))) {
+        if (node->type == NODE_ELEMENT) {
+            index->nodes[next[node->name_id]++] = node;
+        }
+    }
+    free(next);
+    
+    index->node_count = total;
+    index->version = doc->version;
+    index->built = 1;
+}
+
+// Nodos del elemento 'name_id' en orden de documento
+XMLNode** xml_elements_by_name(XMLDocument *doc, uint32_t name_id, size_t *count) {
+    xml_element_index_build(doc);
+    
+    ElementIndex *index = &doc->element_index;
+    if (name_id >= index->name_count) {
+        *count = 0;
+        return NULL;
+    }
+    *count = index->offsets[name_id + 1] - index->offsets[name_id];
+    return index->nodes + index->offsets[name_id];
+}
+
+// Bytes del índice de elementos (0 si aún no se construyó)
+size_t xml_element_index_memory(XMLDocument *doc) {
+    ElementIndex *index = &doc->element_index;
+    if (!index->built) return 0;
+    return (index->name_count + 1) * sizeof(uint32_t) + index->node_count * sizeof(XMLNode*);
+}
+
+// Hash FNV-1a de un par (ID de atributo, valor)
+static uint32_t hash_attribute_value(uint32_t name_id, const char *value) {
+    uint32_t hash = 2166136261u ^ name_id;
+    hash *= 16777619u;
+    for (const unsigned char *p = (const unsigned char*)value; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Posición de la tabla hash del par (name_id, value): la de su grupo o la
+// libre donde iría
+static uint32_t* find_value_slot(const AttributeIndex *index, uint32_t name_id,
+                                 const char *value, uint32_t hash) {
+    uint32_t mask = index->slot_count - 1;
+    uint32_t slot = hash & mask;
+    while (index->slots[slot] != SYMBOL_NONE) {
+        const AttributeValueGroup *group = &index->groups[index->slots[slot]];
+        if (group->hash == hash && group->name_id == name_id && strcmp(group->value, value) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return &index->slots[slot];
+}
+
+// Construir el índice de atributos: un recorrido cuenta los elementos de cada
+// nombre y de cada par, otro los coloca en orden de documento. Un elemento
+// con el mismo atributo repetido aparece una sola vez, como en find_by_attribute
+void xml_attribute_index_build(XMLDocument *doc) {
+    AttributeIndex *index = &doc->attribute_index;
+    if (index->built && index->version == doc->version) {
+        return;
+    }
+    
+    free(index->name_offsets);
+    free(index->name_nodes);
+    free(index->groups);
+    free(index->slots);
+    free(index->value_nodes);
+    
+    uint32_t name_count = doc->names.count;
+    index->name_count = name_count;
+    index->name_offsets = (uint32_t*)calloc(name_count + 1, sizeof(uint32_t));
+    XMLNode **last_named = (XMLNode**)calloc(name_count ? name_count : 1, sizeof(XMLNode*));
+    
+    // Hay como mucho un par distinto por atributo del documento
+    size_t max_groups = doc->attributes.count ? doc->attributes.count : 1;
+    index->groups = (AttributeValueGroup*)malloc(max_groups * sizeof(AttributeValueGroup));
+    XMLNode **last_valued = (XMLNode**)malloc(max_groups * sizeof(XMLNode*));
+    index->group_count = 0;
+    index->slot_count = 16;
+    while (index->slot_count < max_groups * 2) index->slot_count *= 2;
+    index->slots = (uint32_t*)malloc(index->slot_count * sizeof(uint32_t));
+    memset(index->slots, 0xFF, index->slot_count * sizeof(uint32_t));
+    
+    XMLTreeWalker walker;
+    XMLNode *node;
+    size_t named = 0, valued = 0;
+    xml_walker_init_list(&walker, doc->root);
+    while ((node = xml_walker_next(&walker))) {
+        if (node->type != NODE_ELEMENT || !node->attributes) continue;
+        
+        for (Attribute *attr = node->attributes->first; attr; attr = attr->next) {
+            if (last_named[attr->name_id] != node) {
+                last_named[attr->name_id] = node;
+                index->name_offsets[attr->name_id + 1]++;
+                named++;
+            }
+            
+            uint32_t hash = hash_attribute_value(attr->name_id, attr->value);
+            uint32_t *slot = find_value_slot(index, attr->name_id, attr->value, hash);
+            if (*slot == SYMBOL_NONE) {
+                AttributeValueGroup *group = &index->groups[index->group_count];
+                group->name_id = attr->name_id;
+                group->hash = hash;
+                group->value = attr->value;
+                group->count = 0;
+                last_valued[index->group_count] = NULL;
+                *slot = index->group_count++;
+            }
+            if (last_valued[*slot] != node) {
+                last_valued[*slot] = node;
+                index->groups[*slot].count++;
+                valued++;
+            }
+        }
+    }
+    
+    // Inicio de cada nombre y de cada grupo
+    for (uint32_t id = 0; id < name_count; id++) {
+        index->name_offsets[id + 1] += index->name_offsets[id];
+    }
+    uint32_t start = 0;
+    for (uint32_t i = 0; i < index->group_count; i++) {
+        index->groups[i].start = start;
+        start += index->groups[i].count;
+        index->groups[i].count = 0;
+        last_valued[i] = NULL;
+    }
+    
+    uint32_t *next = (uint32_t*)malloc((name_count ? name_count : 1) * sizeof(uint32_t));
+    memcpy(next, index->name_offsets, name_count * sizeof(uint32_t));
+    memset(last_named, 0, (name_count ? name_count : 1) * sizeof(XMLNode*));
+    index->name_nodes = (XMLNode**)malloc((named ? named : 1) * sizeof(XMLNode*));
+    index->value_nodes = (XMLNode**)malloc((valued ? valued : 1) * sizeof(XMLNode*));
+    
+    xml_walker_init_list(&walker, doc->root);
+    while ((node = xml_walker_next(&walker))) {
+        if (node->type != NODE_ELEMENT || !node->attributes) continue;
+        
+        for (Attribute *attr = node->attributes->first; attr; attr = attr->next) {
+            if (last_named[attr->name_id] != node) {
+                last_named[attr->name_id] = node;
+                index->name_nodes[next[attr->name_id]++] = node;
+            }
+            
+            uint32_t hash = hash_attribute_value(attr->name_id, attr->value);
+            uint32_t group_index = *find_value_slot(index, attr->name_id, attr->value, hash);
+            AttributeValueGroup *group = &index->groups[group_index];
+            if (last_valued[group_index] != node) {
+                last_valued[group_index] = node;
+                index->value_nodes[group->start + group->count++] = node;
+            }
+        }
+    }
+    free(next);
+    free(last_named);
+    free(last_valued);
+    
+    index->name_node_count = named;
+    index->value_node_count = valued;
+    index->version = doc->version;
+    index->built = 1;
+}
+
+// Elementos con un atributo (value == NULL) o con un par atributo-valor
+XMLNode** xml_elements_with_attribute(XMLDocument *doc, uint32_t name_id, const char *value, size_t *count) {
+    xml_attribute_index_build(doc);
+    
+    AttributeIndex *index = &doc->attribute_index;
+    *count = 0;
+    if (name_id >= index->name_count) {
+        return NULL;
+    }
+    
+    if (!value) {
+        *count = index->name_offsets[name_id + 1] - index->name_offsets[name_id];
+        return index->name_nodes + index->name_offsets[name_id];
+    }
+    
+    uint32_t group_index = *find_value_slot(index, name_id, value, hash_attribute_value(name_id, value));
+    if (group_index == SYMBOL_NONE) {
+        return NULL;
+    }
+    *count = index->groups[group_index].count;
+    return index->value_nodes + index->groups[group_index].start;
+}
+
+// Bytes del índice de atributos (0 si aún no se construyó)
+size_t xml_attribute_index_memory(XMLDocument *doc) {
+    AttributeIndex *index = &doc->attribute_index;
+    if (!index->built) return 0;
+    return (index->name_count + 1) * sizeof(uint32_t) + index->name_node_count * sizeof(XMLNode*) +
+           index->group_count * sizeof(AttributeValueGroup) + index->slot_count * sizeof(uint32_t) +
+           index->value_node_count * sizeof(XMLNode*);
+}
+
+static uint32_t hash_path_step(uint32_t parent, uint32_t name_id) {
+    return (parent * 2654435761u) ^ (name_id * 40503u + 0x9E3779B9u);
+}
+
+// Posición de la tabla del camino hijo (parent, name_id): la suya o la libre
+static uint32_t* find_path_slot(const PathSummary *summary, uint32_t parent, uint32_t name_id) {
+    uint32_t mask = summary->slot_count - 1;
+    uint32_t slot = hash_path_step(parent, name_id) & mask;
+    while (summary->slots[slot] != PATH_NONE) {
+        const PathSummaryNode *path = &summary->paths[summary->slots[slot]];
+        if (path->parent == parent && path->name_id == name_id) break;
+        slot = (slot + 1) & mask;
+    }
+    return &summary->slots[slot];
+}
+
+static void grow_path_slots(PathSummary *summary) {
+    free(summary->slots);
+    summary->slot_count = summary->slot_count ? summary->slot_count * 2 : 64;
+    summary->slots = (uint32_t*)malloc(summary->slot_count * sizeof(uint32_t));
+    memset(summary->slots, 0xFF, summary->slot_count * sizeof(uint32_t));
+    for (uint32_t i = 0; i < summary->path_count; i++) {
+        *find_path_slot(summary, summary->paths[i].parent, summary->paths[i].name_id) = i;
+    }
+}
+
+// Camino hijo de 'parent' con ese nombre, creándolo si no existe
+static uint32_t add_path(PathSummary *summary, uint32_t parent, uint32_t name_id, uint32_t depth) {
+    uint32_t *slot = find_path_slot(summary, parent, name_id);
+    if (*slot != PATH_NONE) return *slot;
+    
+    if ((summary->path_count + 1) * 2 > summary->slot_count) {
+        grow_path_slots(summary);
+        slot = find_path_slot(summary, parent, name_id);
+    }
+    if (summary->path_count == summary->path_capacity) {
+        summary->path_capacity = summary->path_capacity ? summary->path_capacity * 2 : 32;
+        summary->paths = (PathSummaryNode*)realloc(summary->paths,
+                                                   summary->path_capacity * sizeof(PathSummaryNode));
+    }
+    
+    uint32_t id = summary->path_count++;
+    PathSummaryNode *path = &summary->paths[id];
+    path->name_id = name_id;
+    path->parent = parent;
+    path->first_child = PATH_NONE;
+    path->last_child = PATH_NONE;
+    path->next_sibling = PATH_NONE;
+    path->depth = depth;
+    path->count = 0;
+    if (parent != PATH_NONE) {
+        PathSummaryNode *up = &summary->paths[parent];
+        if (up->last_child == PATH_NONE) {
+            up->first_child = id;
+        } else {
+            summary->paths[up->last_child].next_sibling = id;
+        }
+        up->last_child = id;
+    }
+    *slot = id;
+    return id;
+}
+
+// Construir el resumen en tiempo lineal: un recorrido asigna a cada elemento
+// su camino (con una pila del camino abierto en cada profundidad) y cuenta
+// los elementos de cada camino; otro los coloca en orden de documento
+void xml_path_summary_build(XMLDocument *doc) {
+    PathSummary *summary = &doc->path_summary;
+    if (summary->built && summary->version == doc->version) {
+        return;
+    }
+    
+    double start = xml_time_now();
+    free(summary->paths);
+    free(summary->slots);
+    free(summary->nodes);
+    memset(summary, 0, sizeof(PathSummary));
+    grow_path_slots(summary);
+    
+    uint32_t *open = NULL;          // Camino abierto en cada profundidad
+    int open_capacity = 0;
+    uint32_t *path_of = NULL;       // Camino de cada elemento en preorden
+    size_t elements = 0, path_of_capacity = 0;
+    
+    XMLTreeWalker walker;
+    XMLNode *node;
+    int leaving, depth;
+    xml_walker_init_list(&walker, doc->root);
+    while ((node = xml_walker_step(&walker, &leaving, &depth))) {
+        if (leaving || node->type != NODE_ELEMENT) continue;
+        
+        if (depth >= open_capacity) {
+            open_capacity = open_capacity ? open_capacity * 2 : 64;
+            while (depth >= open_capacity) open_capacity *= 2;
+            open = (uint32_t*)realloc(open, open_capacity * sizeof(uint32_t));
+        }
+        if (elements == path_of_capacity) {
+            path_of_capacity = path_of_capacity ? path_of_capacity * 2 : 1024;
+            path_of = (uint32_t*)realloc(path_of, path_of_capacity * sizeof(uint32_t));
+        }
+        
+        uint32_t parent = depth == 0 ? PATH_NONE : open[depth - 1];
+        uint32_t path = add_path(summary, parent, node->name_id, (uint32_t)depth);
+        summary->paths[path].count++;
+        open[depth] = path;
+        path_of[elements++] = path;
+    }
+    
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < summary->path_count; i++) {
+        summary->paths[i].offset = offset;
+        offset += summary->paths[i].count;
+        summary->paths[i].count = 0;
+    }
+    
+    summary->nodes = (XMLNode**)malloc((elements ? elements : 1) * sizeof(XMLNode*));
+    size_t i = 0;
+    xml_walker_init_list(&walker, doc->root);
+    while ((node = xml_walker_next(&walker))) {
+        if (node->type != NODE_ELEMENT) continue;
+        PathSummaryNode *path = &summary->paths[path_of[i++]];
+        summary->nodes[path->offset + path->count++] = node;
+    }
+    free(open);
+    free(path_of);
+    
+    summary->node_count = elements;
+    summary->build_seconds = xml_time_now() - start;
+    summary->version = doc->version;
+    summary->built = 1;
+}
+
+// Elementos de un camino de solo hijos desde la raíz
+XMLNode** xml_elements_by_path(XMLDocument *doc, const uint32_t *names, int length, size_t *count) {
+    xml_path_summary_build(doc);
+    
+    PathSummary *summary = &doc->path_summary;
+    uint32_t path = PATH_NONE;
+    *count = 0;
+    for (int i = 0; i < length; i++) {
+        if (names[i] == SYMBOL_NONE) return NULL;
+        path = *find_path_slot(summary, path, names[i]);
+        if (path == PATH_NONE) return NULL;
+    }
+    if (path == PATH_NONE) return NULL;
+    
+    *count = summary->paths[path].count;
+    return summary->nodes + summary->paths[path].offset;
+}
+
+// Bytes del resumen de caminos (0 si aún no se construyó)
+size_t xml_path_summary_memory(XMLDocument *doc) {
+    PathSummary *summary = &doc->path_summary;
+    if (!summary->built) return 0;
+    return summary->path_capacity * sizeof(PathSummaryNode) + summary->slot_count * sizeof(uint32_t) +
+           summary->node_count * sizeof(XMLNode*);
+}
+
+// ¿Forma parte de una palabra? (los bytes UTF-8 no ASCII cuentan como letras,
+// así las palabras con acentos quedan enteras)
+static int is_word_byte(unsigned char c) {
+    return isalnum(c) || c >= 0x80;
+}
+
+int xml_text_contains(const char *text, const char *search, int token) {
+    if (!token) return strstr(text, search) != NULL;
+    
+    size_t length = strlen(search);
+    if (length == 0) return 0;
+    for (const char *p = strstr(text, search); p; p = strstr(p + 1, search)) {
+        if (xml_text_match_at(text, p, length, 1)) return 1;
+    }
+    return 0;
+}
+
+int xml_text_match_at(const char *text, const char *at, size_t length, int token) {
+    if (!token) return 1;
+    return (at == text || !is_word_byte((unsigned char)at[-1])) && !is_word_byte((unsigned char)at[length]);
+}
+
+static uint32_t trigram_key(const char *p) {
+    const unsigned char *bytes = (const unsigned char*)p;
+    return (uint32_t)bytes[0] << 16 | (uint32_t)bytes[1] << 8 | bytes[2];
+}
+
+// Posición del trigrama en la tabla: la suya o la libre donde iría
+static TextTrigram* find_trigram(const TextIndex *index, uint32_t key) {
+    uint32_t mask = index->trigram_slots - 1;
+    uint32_t hash = key * 2654435761u;
+    uint32_t slot = (hash ^ (hash >> 16)) & mask;
+    while (index->trigrams[slot].key != 0 && index->trigrams[slot].key != key) {
+        slot = (slot + 1) & mask;
+    }
+    return &index->trigrams[slot];
+}
+
+static void grow_trigrams(TextIndex *index) {
+    TextTrigram *old = index->trigrams;
+    uint32_t old_slots = index->trigram_slots;
+    index->trigram_slots = old_slots ? old_slots * 2 : 1024;
+    index->trigrams = (TextTrigram*)calloc(index->trigram_slots, sizeof(TextTrigram));
+    for (uint32_t i = 0; i < old_slots; i++) {
+        if (old[i].key != 0) *find_trigram(index, old[i].key) = old[i];
+    }
+    free(old);
+}
+
+// Construir el índice con dos pasadas sobre los textos: contar los nodos de
+// cada trigrama (una vez por nodo) y luego colocarlos en orden de documento
+void xml_text_index_build(XMLDocument *doc) {
+    TextIndex *index = &doc->text_index;
+    if (index->built && index->version == doc->version) {
+        return;
+    }
+    
+    double start = xml_time_now();
+    free(index->texts);
+    free(index->trigrams);
+    free(index->postings);
+    memset(index, 0, sizeof(TextIndex));
+    grow_trigrams(index);
+    
+    uint32_t capacity = 0;
+    XMLTreeWalker walker;
+    XMLNode *node;
+    xml_walker_init_list(&walker, doc->root);
+    while ((node = xml_walker_next(&walker))) {
+        if ((node->type != NODE_TEXT && node->type != NODE_CDATA) || !node->parent || !node->content) continue;
+        
+        if (index->text_count == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            index->texts = (XMLNode**)realloc(index->texts, capacity * sizeof(XMLNode*));
+        }
+        uint32_t id = index->text_count++;
+        index->texts[id] = node;
+        
+        size_t length = strlen(node->content);
+        index->text_bytes += length;
+        for (size_t i = 0; i + 3 <= length; i++) {
+            uint32_t key = trigram_key(node->content + i);
+            TextTrigram *trigram = find_trigram(index, key);
+            if (trigram->key == 0) {
+                if ((index->trigram_count + 1) * 2 > index->trigram_slots) {
+                    grow_trigrams(index);
+                    trigram = find_trigram(index, key);
+                }
+                trigram->key = key;
+                index->trigram_count++;
+            }
+            if (trigram->last != id + 1) {
+                trigram->last = id + 1;
+                trigram->count++;
+            }
+        }
+    }
+    
+    size_t total = 0;
+    for (uint32_t i = 0; i < index->trigram_slots; i++) {
+        TextTrigram *trigram = &index->trigrams[i];
+        trigram->start = (uint32_t)total;
+        total += trigram->count;
+        trigram->count = 0;
+        trigram->last = 0;
+    }
+    
+    index->postings = (uint32_t*)malloc((total ? total : 1) * sizeof(uint32_t));
+    for (uint32_t id = 0; id < index->text_count; id++) {
+        const char *content = index->texts[id]->content;
+        size_t length = strlen(content);
+        for (size_t i = 0; i + 3 <= length; i++) {
+            TextTrigram *trigram = find_trigram(index, trigram_key(content + i));
+            if (trigram->last != id + 1) {
+                trigram->last = id + 1;
+                index->postings[trigram->start + trigram->count++] = id;
+            }
+        }
+    }
+    
+    index->posting_count = total;
+    index->build_seconds = xml_time_now() - start;
+    index->version = doc->version;
+    index->built = 1;
+}
+
+// ¿Está 'id' en la lista ordenada? (búsqueda binaria)
+static int posting_contains(const uint32_t *list, uint32_t count, uint32_t id) {
+    uint32_t low = 0, high = count;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (list[middle] < id) low = middle + 1;
+        else high = middle;
+    }
+    return low < count && list[low] == id;
+}
+
+// Los candidatos son la lista más corta entre las de los trigramas de la
+// búsqueda, filtrada con búsquedas binarias en las demás; sin trigramas
+// (menos de tres bytes) se comprueban todos los nodos de texto. Los padres
+// de los nodos que contienen la búsqueda se ordenan por su número
+XMLNode** xml_elements_containing_text(XMLDocument *doc, const char *text, int token, size_t *count) {
+    xml_text_index_build(doc);
+    xml_number_nodes(doc);
+    
+    TextIndex *index = &doc->text_index;
+    size_t length = strlen(text);
+    const uint32_t *candidates = NULL;
+    uint32_t candidate_count = index->text_count;
+    *count = 0;
+    
+    if (length >= 3) {
+        const TextTrigram *shortest = NULL;
+        for (size_t i = 0; i + 3 <= length; i++) {
+            const TextTrigram *trigram = find_trigram(index, trigram_key(text + i));
+            if (trigram->key == 0) return NULL;
+            if (!shortest || trigram->count < shortest->count) shortest = trigram;
+        }
+        candidates = index->postings + shortest->start;
+        candidate_count = shortest->count;
+    }
+    
+    XMLNode **nodes = NULL;
+    size_t capacity = 0;
+    for (uint32_t c = 0; c < candidate_count; c++) {
+        uint32_t id = candidates ? candidates[c] : c;
+        int possible = 1;
+        for (size_t i = 0; candidates && possible && i + 3 <= length; i++) {
+            const TextTrigram *trigram = find_trigram(index, trigram_key(text + i));
+            possible = posting_contains(index->postings + trigram->start, trigram->count, id);
+        }
+        XMLNode *node = index->texts[id];
+        if (!possible || !xml_text_contains(node->content, text, token)) continue;
+        
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            nodes = (XMLNode**)realloc(nodes, capacity * sizeof(XMLNode*));
+        }
+        nodes[(*count)++] = node->parent;
+    }
+    
+    xml_sort_document_order(nodes, count);
+    return nodes;
+}
+
+// Bytes del índice de texto (0 si aún no se construyó)
+size_t xml_text_index_memory(XMLDocument *doc) {
+    TextIndex *index = &doc->text_index;
+    if (!index->built) return 0;
+    return index->text_count * sizeof(XMLNode*) + index->trigram_slots * sizeof(TextTrigram) +
+           index->posting_count * sizeof(uint32_t);
+}
+
+// Numerar en un solo recorrido: pre al entrar en cada nodo y size al salir
+void xml_number_nodes(XMLDocument *doc) {
+    if (doc->numbered && doc->numbering_version == doc->version) {
+        return;
+    }
+    
+    XMLTreeWalker walker;
+    XMLNode *node;
+    int leaving, depth;
+    uint32_t next = 0;
+    xml_walker_init_list(&walker, doc->root);
+    while ((node = xml_walker_step(&walker, &leaving, &depth))) {
+        if (!leaving) {
+            node->pre = next++;
+            node->depth = (uint32_t)depth;
+        } else {
+            node->size = next - node->pre;
+        }
+    }
+    
+    doc->numbering_version = doc->version;
+    doc->numbered = 1;
+}
+
+// ¿Está 'node' dentro del subárbol de 'ancestor' (sin ser él)?
+int xml_is_ancestor(const XMLNode *ancestor, const XMLNode *node) {
+    return node->pre > ancestor->pre && node->pre < ancestor->pre + ancestor->size;
+}
+
+static int compare_document_order(const void *a, const void *b) {
+    uint32_t pre_a = (*(XMLNode* const*)a)->pre;
+    uint32_t pre_b = (*(XMLNode* const*)b)->pre;
+    return pre_a < pre_b ? -1 : pre_a > pre_b;
+}
+
+// Ordenar por pre y quitar repetidos (quedan contiguos)
+void xml_sort_document_order(XMLNode **nodes, size_t *count) {
+    if (*count < 2) return;
+    
+    qsort(nodes, *count, sizeof(XMLNode*), compare_document_order);
+    size_t kept = 1;
+    for (size_t i = 1; i < *count; i++) {
+        if (nodes[i] != nodes[kept - 1]) {
+            nodes[kept++] = nodes[i];
+        }
+    }
+    *count = kept;
+}
+
 // Crear un elemento XML
-XMLNode* create_element(char *name, AttributeList *attrs, XMLNode *children) {
-    XMLNode *node = (XMLNode*)malloc(sizeof(XMLNode));
+XMLNode* create_element(XMLDocument *doc, uint32_t name_id, AttributeList *attrs, XMLNode *children) {
+    XMLNode *node = (XMLNode*)pool_alloc(&doc->nodes);
+    doc->version++;
     node->type = NODE_ELEMENT;
-    node->name = strdup(name);
+    node->name_id = name_id;
+    node->name = doc->names.names[name_id];
     node->content = NULL;
     node->attributes = attrs;
     node->children = children;
     node->next = NULL;
     node->parent = NULL;
+    node->pre = 0;
+    node->size = 0;
+    node->depth = 0;
     
     // Establecer el padre de los hijos
     XMLNode *child = children;
@@ -23,44 +727,55 @@ XMLNode* create_element(char *name, AttributeList *attrs, XMLNode *children) {
 }
 
 // Crear un nodo de texto
-XMLNode* create_text_node(char *text) {
-    XMLNode *node = (XMLNode*)malloc(sizeof(XMLNode));
+XMLNode* create_text_node(XMLDocument *doc, char *text) {
+    XMLNode *node = (XMLNode*)pool_alloc(&doc->nodes);
+    doc->version++;
     node->type = NODE_TEXT;
+    node->name_id = SYMBOL_NONE;
     node->name = NULL;
-    node->content = strdup(text);
+    node->content = text;
     node->attributes = NULL;
     node->children = NULL;
     node->next = NULL;
     node->parent = NULL;
+    node->pre = 0;
+    node->size = 0;
+    node->depth = 0;
     return node;
 }
 
 // Crear un nodo CDATA
-XMLNode* create_cdata_node(char *data) {
-    XMLNode *node = (XMLNode*)malloc(sizeof(XMLNode));
+XMLNode* create_cdata_node(XMLDocument *doc, char *data) {
+    XMLNode *node = (XMLNode*)pool_alloc(&doc->nodes);
+    doc->version++;
     node->type = NODE_CDATA;
+    node->name_id = SYMBOL_NONE;
     node->name = NULL;
-    node->content = strdup(data);
+    node->content = data;
     node->attributes = NULL;
     node->children = NULL;
     node->next = NULL;
     node->parent = NULL;
+    node->pre = 0;
+    node->size = 0;
+    node->depth = 0;
     return node;
 }
 
 // Crear un atributo
-Attribute* create_attribute(char *name, char *value) {
-    Attribute *attr = (Attribute*)malloc(sizeof(Attribute));
-    attr->name = strdup(name);
-    attr->value = strdup(value);
+Attribute* create_attribute(XMLDocument *doc, uint32_t name_id, char *value) {
+    Attribute *attr = (Attribute*)pool_alloc(&doc->attributes);
+    attr->name_id = name_id;
+    attr->name = doc->names.names[name_id];
+    attr->value = value;
     attr->next = NULL;
     return attr;
 }
 
 // Agregar atributo a la lista
-AttributeList* add_attribute(AttributeList *list, Attribute *attr) {
+AttributeList* add_attribute(XMLDocument *doc, AttributeList *list, Attribute *attr) {
     if (!list) {
-        list = (AttributeList*)malloc(sizeof(AttributeList));
+        list = (AttributeList*)pool_alloc(&doc->attribute_lists);
         list->first = NULL;
         list->last = NULL;
         list->count = 0;
@@ -74,214 +789,177 @@ AttributeList* add_attribute(AttributeList *list, Attribute *attr) {
         list->last = attr;
     }
     list->count++;
+    doc->version++;
     return list;
 }
 
-// Agregar contenido a la lista
-XMLNode* add_content(XMLNode *list, XMLNode *node) {
-    if (!list) {
-        return node;
-    }
-    
-    XMLNode *current = list;
-    while (current->next) {
-        current = current->next;
+// Agregar contenido al final de la lista
+NodeList add_content(NodeList list, XMLNode *node) {
+    if (!list.first) {
+        list.first = node;
+    } else {
+        list.last->next = node;
     }
-    current->next = node;
+    list.last = node;
     return list;
 }
 
-// Imprimir el árbol XML
-void print_xml_tree(XMLNode *node, int depth) {
-    if (!node) return;
-    
-    for (int i = 0; i < depth; i++) printf("  ");
-    
-    switch (node->type) {
-        case NODE_ELEMENT:
-            printf("<%s", node->name);
-            if (node->attributes) {
-                Attribute *attr = node->attributes->first;
-                while (attr) {
-                    printf(" %s=\"%s\"", attr->name, attr->value);
-                    attr = attr->next;
-                }
-            }
-            printf(">\n");
-            
-            print_xml_tree(node->children, depth + 1);
-            
-            for (int i = 0; i < depth; i++) printf("  ");
-            printf("</%s>\n", node->name);
-            break;
-            
-        case NODE_TEXT:
-            printf("TEXT: %s\n", node->content);
-            break;
-            
-        case NODE_CDATA:
-            printf("CDATA: %s\n", node->content);
-            break;
-    }
-    
-    print_xml_tree(node->next, depth);
+// Iniciar el recorrido del subárbol de 'root'
+void xml_walker_init(XMLTreeWalker *walker, XMLNode *root) {
+    walker->node = root;
+    walker->depth = 0;
+    walker->leaving = 0;
+    walker->siblings = 0;
 }
 
-// Liberar memoria del árbol
-void free_xml_tree(XMLNode *node) {
-    if (!node) return;
-    
-    free_xml_tree(node->children);
-    free_xml_tree(node->next);
+// Iniciar el recorrido de una lista de hermanos y sus descendientes
+void xml_walker_init_list(XMLTreeWalker *walker, XMLNode *first) {
+    xml_walker_init(walker, first);
+    walker->siblings = 1;
+}
+
+// Avanzar un paso: entrar en el nodo actual o salir de él
+XMLNode* xml_walker_step(XMLTreeWalker *walker, int *leaving, int *depth) {
+    XMLNode *node = walker->node;
+    if (!node) return NULL;
     
-    if (node->name) free(node->name);
-    if (node->content) free(node->content);
+    if (leaving) *leaving = walker->leaving;
+    if (depth) *depth = walker->depth;
     
-    if (node->attributes) {
-        Attribute *attr = node->attributes->first;
-        while (attr) {
-            Attribute *next = attr->next;
-            free(attr->name);
-            free(attr->value);
-            free(attr);
-            attr = next;
+    if (!walker->leaving) {
+        if (node->children) {
+            walker->node = node->children;
+            walker->depth++;
+        } else {
+            walker->leaving = 1;  // Hoja: el próximo paso sale de ella
         }
-        free(node->attributes);
+    } else if (node->next && (walker->depth > 0 || walker->siblings)) {
+        walker->node = node->next;
+        walker->leaving = 0;
+    } else if (walker->depth > 0) {
+        walker->node = node->parent;
+        walker->depth--;
+    } else {
+        walker->node = NULL;
     }
-    
-    free(node);
+    return node;
 }
 
-// Contar elementos
-int count_elements(XMLNode *node) {
-    if (!node) return 0;
-    
-    int count = 0;
-    if (node->type == NODE_ELEMENT) {
-        count = 1;
-        count += count_elements(node->children);
+// Siguiente nodo en preorden
+XMLNode* xml_walker_next(XMLTreeWalker *walker) {
+    XMLNode *node;
+    int leaving;
+    while ((node = xml_walker_step(walker, &leaving, NULL)) && leaving) {
     }
-    count += count_elements(node->next);
-    return count;
+    return node;
 }
 
-// Contar atributos
-int count_attributes(XMLNode *node) {
-    if (!node) return 0;
-    
-    int count = 0;
-    if (node->type == NODE_ELEMENT && node->attributes) {
-        count = node->attributes->count;
-        count += count_attributes(node->children);
-    }
-    count += count_attributes(node->next);
-    return count;
+static void print_indent(int depth) {
+    for (int i = 0; i < depth; i++) printf("  ");
 }
 
-// Funciones auxiliares para XPath
-XMLNode* find_elements_by_name(XMLNode *node, const char *name) {
-    if (!node) return NULL;
-    
-    XMLNode *result = NULL;
-    XMLNode *last_result = NULL;
+// Imprimir la forma del documento: cada camino con su número de elementos,
+// sangrado por profundidad (recorrido iterativo del resumen)
+void print_path_summary(XMLDocument *doc) {
+    xml_path_summary_build(doc);
     
-    if (node->type == NODE_ELEMENT && strcmp(node->name, name) == 0) {
-        result = (XMLNode*)malloc(sizeof(XMLNode));
-        memcpy(result, node, sizeof(XMLNode));
-        result->next = NULL;
-        last_result = result;
-    }
+    PathSummary *summary = &doc->path_summary;
+    printf("\nResumen de caminos: %u camino(s) para %zu elemento(s), %zu KB, %.3f ms\n",
+           summary->path_count, summary->node_count, xml_path_summary_memory(doc) / 1024,
+           summary->build_seconds * 1000.0);
     
-    // Buscar en hijos
-    XMLNode *child_results = find_elements_by_name(node->children, name);
-    if (child_results) {
-        if (result) {
-            last_result->next = child_results;
-        } else {
-            result = child_results;
-        }
-        while (last_result && last_result->next) {
-            last_result = last_result->next;
+    uint32_t path = summary->path_count > 0 ? 0 : PATH_NONE;
+    while (path != PATH_NONE) {
+        PathSummaryNode *current = &summary->paths[path];
+        uint32_t depth = current->depth < 40 ? current->depth : 40;
+        printf("%10u  ", current->count);
+        print_indent((int)depth);
+        printf("/%s", symbol_name(&doc->names, current->name_id));
+        if (current->depth > depth) printf("  (nivel %u)", current->depth);
+        printf("\n");
+        
+        // Siguiente camino en preorden
+        if (current->first_child != PATH_NONE) {
+            path = current->first_child;
+            continue;
         }
-    }
-    
-    // Buscar en hermanos
-    XMLNode *sibling_results = find_elements_by_name(node->next, name);
-    if (sibling_results) {
-        if (result) {
-            last_result->next = sibling_results;
-        } else {
-            result = sibling_results;
+        while (path != PATH_NONE && summary->paths[path].next_sibling == PATH_NONE) {
+            path = summary->paths[path].parent;
         }
+        if (path != PATH_NONE) path = summary->paths[path].next_sibling;
     }
-    
-    return result;
 }
 
-// Implementación básica de XPath
-XMLNode* xpath_query(XMLNode *root, const char *xpath) {
-    if (!root || !xpath) return NULL;
+// Imprimir los nodos de un recorrido ya iniciado
+static void print_walk(XMLTreeWalker *walker, int depth) {
+    XMLNode *node;
+    int leaving, level;
     
-    // Implementación básica para consultas simples
-    if (xpath[0] == '/') {
-        // Consulta absoluta
-        if (xpath[1] == '/') {
-            // Búsqueda en todo el documento
-            return find_elements_by_name(root, xpath + 2);
-        } else {
-            // Búsqueda desde la raíz
-            return find_elements_by_name(root, xpath + 1);
+    while ((node = xml_walker_step(walker, &leaving, &level))) {
+        if (leaving) {
+            if (node->type == NODE_ELEMENT) {
+                print_indent(depth + level);
+                printf("</%s>\n", node->name);
+            }
+            continue;
+        }
+        
+        print_indent(depth + level);
+        switch (node->type) {
+            case NODE_ELEMENT:
+                printf("<%s", node->name);
+                if (node->attributes) {
+                    Attribute *attr = node->attributes->first;
+                    while (attr) {
+                        printf(" %s=\"%s\"", attr->name, attr->value);
+                        attr = attr->next;
+                    }
+                }
+                printf(">\n");
+                break;
+                
+            case NODE_TEXT:
+                printf("TEXT: %s\n", node->content);
+                break;
+                
+            case NODE_CDATA:
+                printf("CDATA: %s\n", node->content);
+                break;
         }
-    } else {
-        // Consulta relativa
-        return find_elements_by_name(root, xpath);
     }
 }
 
-// Imprimir resultados de XPath
-void print_xpath_results(XMLNode *results) {
-    XMLNode *current = results;
-    int count = 0;
-    
-    while (current) {
-        count++;
-        printf("Resultado %d:\n", count);
-        print_xml_tree(current, 1);
-        current = current->next;
-    }
+// Imprimir el árbol XML (el nodo y sus hermanos siguientes)
+void print_xml_tree(XMLNode *node, int depth) {
+    XMLTreeWalker walker;
+    xml_walker_init_list(&walker, node);
+    print_walk(&walker, depth);
+}
+
+// Contar elementos
+int count_elements(XMLNode *node) {
+    XMLTreeWalker walker;
+    xml_walker_init_list(&walker, node);
     
-    if (count == 0) {
-        printf("No se encontraron resultados.\n");
-    } else {
-        printf("Total de resultados: %d\n", count);
+    int count = 0;
+    while ((node = xml_walker_next(&walker))) {
+        if (node->type == NODE_ELEMENT) {
+            count++;
+        }
     }
+    return count;
 }
 
-// Modo interactivo para consultas XPath
-void xpath_interactive_mode(XMLNode *root) {
-    char xpath[256];
+// Contar atributos
+int count_attributes(XMLNode *node) {
+    XMLTreeWalker walker;
+    xml_walker_init_list(&walker, node);
     
-    while (1) {
-        printf("XPath> ");
-        if (!fgets(xpath, sizeof(xpath), stdin)) {
-            break;
-        }
-        
-        // Remover salto de línea
-        xpath[strcspn(xpath, "\n")] = '\0';
-        
-        if (strcmp(xpath, "quit") == 0) {
-            break;
-        }
-        
-        if (strlen(xpath) == 0) {
-            continue;
+    int count = 0;
+    while ((node = xml_walker_next(&walker))) {
+        if (node->type == NODE_ELEMENT && node->attributes) {
+            count += node->attributes->count;
         }
-        
-        XMLNode *results = xpath_query(root, xpath);
-        print_xpath_results(results);
-        
-        // Liberar resultados
-        free_xml_tree(results);
     }
-}
\ No newline at end of file
+    return count;
+}
@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "arena.h"
+#include "symbol_table.h"
 
 // Tipos de nodos
 typedef enum {
@@ -14,7 +16,8 @@ typedef enum {
 
 // Estructura para atributos
 typedef struct Attribute {
-    char *name;
+    char *name;           // Nombre internado en la tabla de símbolos
+    uint32_t name_id;
     char *value;
     struct Attribute *next;
 } Attribute;
@@ -28,35 +31,237 @@ typedef struct AttributeList {
 // Estructura para nodos XML
 typedef struct XMLNode {
     NodeType type;
-    char *name;           // Para elementos
+    uint32_t name_id;     // Para elementos: ID en la tabla de símbolos
+    char *name;           // Para elementos (nombre internado)
     char *content;        // Para texto y CDATA
     AttributeList *attributes;
     struct XMLNode *children;
     struct XMLNode *next;
     struct XMLNode *parent;
+    
+    // Numeración del documento (xml_number_nodes): el subárbol ocupa los
+    // números [pre, pre + size) en preorden y depth es 0 en la raíz
+    uint32_t pre;
+    uint32_t size;
+    uint32_t depth;
 } XMLNode;
 
-// Funciones para crear nodos
-XMLNode* create_element(char *name, AttributeList *attrs, XMLNode *children);
-XMLNode* create_text_node(char *text);
-XMLNode* create_cdata_node(char *data);
+// Lista de hermanos en construcción: el último nodo permite agregar en O(1)
+typedef struct NodeList {
+    XMLNode *first;
+    XMLNode *last;
+} NodeList;
+
+// Recorrido en preorden sin recursión ni pila: baja por children, avanza por
+// next y vuelve por parent. Usa memoria constante sea cual sea la profundidad
+// o el número de hermanos. El fin del recorrido se detecta por profundidad,
+// así que también funciona sobre copias de nodos (resultados de XPath)
+typedef struct XMLTreeWalker {
+    XMLNode *node;      // Próximo nodo a devolver
+    int depth;          // Profundidad de 'node' (0 = nivel inicial)
+    int leaving;        // El próximo paso sale de 'node' (hijos ya visitados)
+    int siblings;       // Recorrer también los hermanos siguientes del inicial
+} XMLTreeWalker;
+
+// Índice de elementos por nombre: para cada ID de nombre, sus nodos en orden
+// de documento (los del ID i ocupan nodes[offsets[i]] .. nodes[offsets[i+1]-1]).
+// Se construye en la primera consulta y se reconstruye si el árbol cambió
+typedef struct ElementIndex {
+    uint32_t *offsets;
+    XMLNode **nodes;
+    uint32_t name_count;
+    size_t node_count;
+    unsigned long version;      // Versión del documento indexada
+    int built;
+} ElementIndex;
+
+// Grupo del índice de atributos: elementos con un par (nombre, valor)
+typedef struct AttributeValueGroup {
+    uint32_t name_id;
+    uint32_t hash;
+    const char *value;
+    uint32_t start;             // Primer nodo del grupo en value_nodes
+    uint32_t count;
+} AttributeValueGroup;
+
+// Índice de atributos: por nombre (presencia, [@attr]) y por par nombre-valor
+// (igualdad, [@attr='valor']); cada lista queda en orden de documento.
+// Mismo ciclo de vida que ElementIndex
+typedef struct AttributeIndex {
+    uint32_t *name_offsets;     // Presencia: como ElementIndex, por ID de atributo
+    XMLNode **name_nodes;
+    uint32_t name_count;
+    size_t name_node_count;
+    AttributeValueGroup *groups;    // Un grupo por par distinto
+    uint32_t group_count;
+    uint32_t *slots;            // Tabla hash abierta de índices de grupo
+    uint32_t slot_count;        // (potencia de 2)
+    XMLNode **value_nodes;
+    size_t value_node_count;
+    unsigned long version;
+    int built;
+} AttributeIndex;
+
+#define PATH_NONE 0xFFFFFFFFu
+
+// Camino del resumen: una secuencia distinta de nombres desde la raíz
+typedef struct PathSummaryNode {
+    uint32_t name_id;
+    uint32_t parent;            // Camino sin el último nombre (PATH_NONE en la raíz)
+    uint32_t first_child;
+    uint32_t last_child;
+    uint32_t next_sibling;
+    uint32_t depth;
+    uint32_t offset;            // Primer elemento del camino en nodes
+    uint32_t count;             // Elementos con este camino
+} PathSummaryNode;
+
+// Resumen de caminos (DataGuide): cada camino de nombres del documento con
+// sus elementos en orden de documento; un camino "/a/b/c" de solo hijos se
+// resuelve con una búsqueda. Mismo ciclo de vida que ElementIndex
+typedef struct PathSummary {
+    PathSummaryNode *paths;     // En orden de primera aparición
+    uint32_t path_count;
+    uint32_t path_capacity;
+    uint32_t *slots;            // Tabla hash (camino padre, nombre) -> camino
+    uint32_t slot_count;        // (potencia de 2)
+    XMLNode **nodes;
+    size_t node_count;
+    double build_seconds;
+    unsigned long version;
+    int built;
+} PathSummary;
+
+// Trigrama del índice de texto con su lista de nodos de texto
+typedef struct TextTrigram {
+    uint32_t key;               // Tres bytes (0 = posición libre: el texto no contiene '\0')
+    uint32_t start;             // Primera entrada en postings
+    uint32_t count;
+    uint32_t last;              // Último nodo contado + 1 (solo al construir)
+} TextTrigram;
+
+// Índice de texto: para cada trigrama, los nodos de texto y CDATA que lo
+// contienen, en orden de documento. Una búsqueda cruza las listas de sus
+// trigramas y comprueba solo los nodos que quedan. Mismo ciclo de vida que
+// ElementIndex, pero solo se construye si se pide o si una consulta lo usa
+typedef struct TextIndex {
+    XMLNode **texts;            // Nodos de texto y CDATA en orden de documento
+    uint32_t text_count;
+    size_t text_bytes;          // Bytes de texto indexados
+    TextTrigram *trigrams;      // Tabla hash abierta (potencia de 2)
+    uint32_t trigram_slots;
+    uint32_t trigram_count;
+    uint32_t *postings;         // Listas de nodos (posiciones en texts)
+    size_t posting_count;
+    double build_seconds;
+    unsigned long version;
+    int built;
+} TextIndex;
+
+// Documento XML: las cadenas del lexer y del árbol pertenecen a la arena,
+// los nodos y atributos a pools que se liberan junto con el documento y los
+// nombres de elementos y atributos a la tabla de símbolos (una copia cada uno)
+typedef struct XMLDocument {
+    XMLNode *root;
+    // Identificador único en el proceso: un documento nuevo en la misma
+    // estructura (o en la misma dirección) tiene otro
+    unsigned long id;
+    SymbolTable names;
+    Arena strings;
+    Pool nodes;
+    Pool attributes;
+    Pool attribute_lists;
+    
+    // Cada modificación del árbol incrementa la versión e invalida los índices
+    unsigned long version;
+    ElementIndex element_index;
+    AttributeIndex attribute_index;
+    PathSummary path_summary;
+    TextIndex text_index;
+    unsigned long numbering_version;    // Versión numerada (pre/size/depth)
+    int numbered;
+    
+    // Tabla semántica del análisis (de quien la creó; NULL = sin ella). El
+    // planificador de consultas solo la usa en la versión en que se hizo
+    const struct SemanticTable *statistics;
+    unsigned long statistics_version;
+} XMLDocument;
+
+// Funciones del documento
+void init_xml_document(XMLDocument *doc);
+void free_xml_document(XMLDocument *doc);
+size_t xml_document_memory(XMLDocument *doc);
+void xml_document_changed(XMLDocument *doc);
+
+// Nodos del elemento 'name_id' en orden de documento (construye el índice si
+// falta o está desactualizado; no usar desde varios hilos sobre el mismo
+// documento sin construirlo antes con xml_element_index_build)
+XMLNode** xml_elements_by_name(XMLDocument *doc, uint32_t name_id, size_t *count);
+void xml_element_index_build(XMLDocument *doc);
+size_t xml_element_index_memory(XMLDocument *doc);
+
+// Elementos con el atributo 'name_id' (value == NULL) o con el par
+// (name_id, value), en orden de documento, desde el índice de atributos
+XMLNode** xml_elements_with_attribute(XMLDocument *doc, uint32_t name_id, const char *value, size_t *count);
+void xml_attribute_index_build(XMLDocument *doc);
+size_t xml_attribute_index_memory(XMLDocument *doc);
+
+// Elementos del camino de solo hijos names[0]/names[1]/.../names[length-1]
+// desde la raíz, en orden de documento, desde el resumen de caminos
+XMLNode** xml_elements_by_path(XMLDocument *doc, const uint32_t *names, int length, size_t *count);
+void xml_path_summary_build(XMLDocument *doc);
+size_t xml_path_summary_memory(XMLDocument *doc);
+void print_path_summary(XMLDocument *doc);
+
+// Elementos con algún hijo de texto o CDATA que contiene 'text' (con 'token',
+// como palabra completa), en orden de documento y sin repetidos, desde el
+// índice de texto. El arreglo devuelto se libera con free
+XMLNode** xml_elements_containing_text(XMLDocument *doc, const char *text, int token, size_t *count);
+void xml_text_index_build(XMLDocument *doc);
+size_t xml_text_index_memory(XMLDocument *doc);
+// ¿Contiene 'text' a 'search'? Con 'token', solo entre separadores: las
+// palabras son secuencias de letras y dígitos (los bytes UTF-8 no ASCII
+// cuentan como letras)
+int xml_text_contains(const char *text, const char *search, int token);
+// ¿Es la aparición de 'search' (de 'length' bytes) en la posición 'at' de
+// 'text' una coincidencia? Sin 'token' siempre; con él, si es una palabra entera
+int xml_text_match_at(const char *text, const char *at, size_t length, int token);
+
+// Numerar los nodos en preorden (pre, size, depth) si el árbol cambió desde
+// la última vez. Con la numeración, "ancestro de" es una comparación de
+// rangos y el orden de documento es el orden de pre. Como los índices, no
+// usar desde varios hilos sobre el mismo documento sin numerarlo antes
+void xml_number_nodes(XMLDocument *doc);
+int xml_is_ancestor(const XMLNode *ancestor, const XMLNode *node);
+// Ordenar nodos numerados en orden de documento y quitar los repetidos
+void xml_sort_document_order(XMLNode **nodes, size_t *count);
+
+// Funciones para crear nodos (las cadenas recibidas deben pertenecer a la
+// arena del documento; los nodos las referencian sin copiarlas). Los nombres
+// se reciben como IDs de doc->names
+XMLNode* create_element(XMLDocument *doc, uint32_t name_id, AttributeList *attrs, XMLNode *children);
+XMLNode* create_text_node(XMLDocument *doc, char *text);
+XMLNode* create_cdata_node(XMLDocument *doc, char *data);
 
 // Funciones para atributos
-Attribute* create_attribute(char *name, char *value);
-AttributeList* add_attribute(AttributeList *list, Attribute *attr);
+Attribute* create_attribute(XMLDocument *doc, uint32_t name_id, char *value);
+AttributeList* add_attribute(XMLDocument *doc, AttributeList *list, Attribute *attr);
 
 // Funciones para contenido
-XMLNode* add_content(XMLNode *list, XMLNode *node);
+NodeList add_content(NodeList list, XMLNode *node);
+
+// Recorrido iterativo: xml_walker_init cubre el subárbol de 'root';
+// xml_walker_init_list cubre 'first', sus hermanos siguientes y sus descendientes
+void xml_walker_init(XMLTreeWalker *walker, XMLNode *root);
+void xml_walker_init_list(XMLTreeWalker *walker, XMLNode *first);
+// Paso completo: cada nodo se devuelve al entrar (*leaving = 0) y al salir (*leaving = 1)
+XMLNode* xml_walker_step(XMLTreeWalker *walker, int *leaving, int *depth);
+// Siguiente nodo en preorden (solo entradas); NULL al terminar
+XMLNode* xml_walker_next(XMLTreeWalker *walker);
 
 // Funciones de utilidad
 void print_xml_tree(XMLNode *node, int depth);
-void free_xml_tree(XMLNode *node);
 int count_elements(XMLNode *node);
 int count_attributes(XMLNode *node);
 
-// Funciones para XPath
-void xpath_interactive_mode(XMLNode *root);
-XMLNode* xpath_query(XMLNode *root, const char *xpath);
-void print_xpath_results(XMLNode *results);
-
 #endif
\ No newline at end of file
@@ -1,16 +1,16 @@
-#include "xml_tree.h"
+#define _GNU_SOURCE  // strdup con -std=c99
+#include "xpath_engine.h"
+#include "query_cache.h"
+#include "semantic_analyzer.h"
+#include "thread_pool.h"
+#include "xml_input.h"
 #include <ctype.h>
+#include <errno.h>
+#include <stdint.h>
 #include <string.h>
 
-// Estructura para resultados de XPath
-typedef struct XPathResult {
-    XMLNode **nodes;
-    int count;
-    int capacity;
-} XPathResult;
-
 // Inicializar resultado XPath
-XPathResult* init_xpath_result() {
+XPathResult* init_xpath_result(void) {
     XPathResult *result = (XPathResult*)malloc(sizeof(XPathResult));
     result->nodes = NULL;
     result->count = 0;
@@ -36,25 +36,32 @@ void free_xpath_result(XPathResult *result) {
 }
 
 // Buscar por nombre de elemento
-void find_by_element_name(XMLNode *node, const char *name, XPathResult *result) {
-    if (!node) return;
+void find_by_element_name(XMLNode *node, uint32_t name_id, XPathResult *result) {
+    if (name_id == SYMBOL_NONE) return;
     
-    if (node->type == NODE_ELEMENT && strcmp(node->name, name) == 0) {
-        add_to_result(result, node);
-    }
+    XMLTreeWalker walker;
+    xml_walker_init_list(&walker, node);
     
-    find_by_element_name(node->children, name, result);
-    find_by_element_name(node->next, name, result);
+    while ((node = xml_walker_next(&walker))) {
+        if (node->type == NODE_ELEMENT && node->name_id == name_id) {
+            add_to_result(result, node);
+        }
+    }
 }
 
 // Buscar por atributo
-void find_by_attribute(XMLNode *node, const char *attr_name, const char *attr_value, XPathResult *result) {
-    if (!node) return;
+void find_by_attribute(XMLNode *node, uint32_t attr_id, const char *attr_value, XPathResult *result) {
+    if (attr_id == SYMBOL_NONE) return;
     
-    if (node->type == NODE_ELEMENT && node->attributes) {
+    XMLTreeWalker walker;
+    xml_walker_init_list(&walker, node);
+    
+    while ((node = xml_walker_next(&walker))) {
+        if (node->type != NODE_ELEMENT || !node->attributes) continue;
+        
         Attribute *attr = node->attributes->first;
         while (attr) {
-            if (strcmp(attr->name, attr_name) == 0) {
+            if (attr->name_id == attr_id) {
                 if (!attr_value || strcmp(attr->value, attr_value) == 0) {
                     add_to_result(result, node);
                     break;
@@ -63,18 +70,15 @@ void find_by_attribute(XMLNode *node, const char *attr_name, const char *attr_va
             attr = attr->next;
         }
     }
-    
-    find_by_attribute(node->children, attr_name, attr_value, result);
-    find_by_attribute(node->next, attr_name, attr_value, result);
 }
 
 // Buscar hijos directos
-void find_direct_children(XMLNode *parent, const char *name, XPathResult *result) {
+void find_direct_children(XMLNode *parent, uint32_t name_id, XPathResult *result) {
     if (!parent || !parent->children) return;
     
     XMLNode *child = parent->children;
     while (child) {
-        if (child->type == NODE_ELEMENT && strcmp(child->name, name) == 0) {
+        if (child->type == NODE_ELEMENT && child->name_id == name_id) {
             add_to_result(result, child);
         }
         child = child->next;
@@ -82,14 +86,14 @@ void find_direct_children(XMLNode *parent, const char *name, XPathResult *result
 }
 
 // Buscar por posición
-void find_by_position(XMLNode *parent, const char *name, int position, XPathResult *result) {
+void find_by_position(XMLNode *parent, uint32_t name_id, int position, XPathResult *result) {
     if (!parent || !parent->children) return;
     
     XMLNode *child = parent->children;
     int current_pos = 1;
     
     while (child) {
-        if (child->type == NODE_ELEMENT && strcmp(child->name, name) == 0) {
+        if (child->type == NODE_ELEMENT && child->name_id == name_id) {
             if (current_pos == position) {
                 add_to_result(result, child);
                 return;
@@ -102,112 +106,1691 @@ void find_by_position(XMLNode *parent, const char *name, int position, XPathResu
 
 // Buscar por texto contenido
 void find_by_text_content(XMLNode *node, const char *text, XPathResult *result) {
-    if (!node) return;
+    XMLTreeWalker walker;
+    xml_walker_init_list(&walker, node);
     
-    if (node->type == NODE_TEXT && strstr(node->content, text)) {
-        if (node->parent) {
+    while ((node = xml_walker_next(&walker))) {
+        if (node->type == NODE_TEXT && strstr(node->content, text) && node->parent) {
             add_to_result(result, node->parent);
         }
     }
+}
+
+// Fin del rango en preorden que cubre 'node', sus hermanos siguientes y sus
+// descendientes (las búsquedas recorren la lista como las de punteros)
+static uint32_t compact_list_end(CompactTree *tree, uint32_t node) {
+    uint32_t parent = tree->parent[node];
+    return parent == COMPACT_NONE ? tree->node_count : compact_subtree_end(tree, parent);
+}
+
+// Buscar por nombre de elemento: comparación de IDs sobre un arreglo contiguo
+void compact_find_by_element_name(CompactTree *tree, uint32_t node, uint32_t id, CompactResult *result) {
+    if (id == SYMBOL_NONE) return;
+    
+    uint32_t end = compact_list_end(tree, node);
+    const uint32_t *names = tree->name;
+    for (uint32_t i = node; i < end; i++) {
+        if (names[i] == id) {
+            add_compact_result(result, i);
+        }
+    }
+}
+
+// Buscar por atributo
+void compact_find_by_attribute(CompactTree *tree, uint32_t node, uint32_t id,
+                               const char *attr_value, CompactResult *result) {
+    if (id == SYMBOL_NONE) return;
     
-    find_by_text_content(node->children, text, result);
-    find_by_text_content(node->next, text, result);
+    uint32_t end = compact_list_end(tree, node);
+    for (uint32_t i = node; i < end; i++) {
+        if (tree->type[i] != NODE_ELEMENT) continue;
+        
+        uint32_t first = tree->span_start[i];
+        uint32_t last = first + tree->span_length[i];
+        for (uint32_t a = first; a < last; a++) {
+            if (tree->attr_name[a] == id &&
+                (!attr_value || strcmp(tree->text + tree->attr_value[a], attr_value) == 0)) {
+                add_compact_result(result, i);
+                break;
+            }
+        }
+    }
 }
 
-// Parser mejorado de XPath
-XPathResult* xpath_query_extended(XMLNode *root, const char *xpath) {
-    XPathResult *result = init_xpath_result();
+// Buscar hijos directos
+void compact_find_direct_children(CompactTree *tree, uint32_t parent, uint32_t id, CompactResult *result) {
+    if (id == SYMBOL_NONE) return;
+    
+    for (uint32_t child = tree->first_child[parent]; child != COMPACT_NONE; child = tree->next_sibling[child]) {
+        if (tree->name[child] == id) {
+            add_compact_result(result, child);
+        }
+    }
+}
+
+// Buscar por posición
+void compact_find_by_position(CompactTree *tree, uint32_t parent, uint32_t id, int position,
+                              CompactResult *result) {
+    if (id == SYMBOL_NONE) return;
+    
+    int current_pos = 1;
+    for (uint32_t child = tree->first_child[parent]; child != COMPACT_NONE; child = tree->next_sibling[child]) {
+        if (tree->name[child] == id) {
+            if (current_pos == position) {
+                add_compact_result(result, child);
+                return;
+            }
+            current_pos++;
+        }
+    }
+}
+
+// Buscar por texto contenido
+void compact_find_by_text_content(CompactTree *tree, uint32_t node, const char *text, CompactResult *result) {
+    uint32_t end = compact_list_end(tree, node);
+    for (uint32_t i = node; i < end; i++) {
+        if (tree->type[i] == NODE_TEXT && strstr(tree->text + tree->span_start[i], text) &&
+            tree->parent[i] != COMPACT_NONE) {
+            add_compact_result(result, tree->parent[i]);
+        }
+    }
+}
+
+// Prueba de nombre de un paso: '*' (o vacía, como en "[@id]") acepta
+// cualquier elemento
+static void compile_name_test(XPathPlan *plan, const char *token, XPathPlanStep *step) {
+    if (token[0] == '\0' || strcmp(token, "*") == 0) {
+        step->any_name = 1;
+    } else {
+        step->name = symbol_intern(&plan->names, token, strlen(token));
+    }
+}
+
+// Saltar 'word' (y los espacios de delante) si está en 'p'; NULL si no
+static char* skip_word(char *p, const char *word) {
+    while (*p == ' ') p++;
+    size_t length = strlen(word);
+    return strncmp(p, word, length) == 0 ? p + length : NULL;
+}
+
+// Predicado de texto: contains(text(),'x') o contains-token(text(),'x'). Si
+// no tiene esa forma el paso queda inválido
+static void compile_text_predicate(char *predicate, XPathPlanStep *step) {
+    int token = strncmp(predicate, "contains-token(", 15) == 0;
+    char *p = skip_word(predicate, token ? "contains-token(" : "contains(");
+    if (p) p = skip_word(p, "text()");
+    if (p) p = skip_word(p, ",");
+    while (p && *p == ' ') p++;
     
-    if (!root || !xpath) return result;
+    step->kind = STEP_INVALID;
+    if (!p || (*p != '\'' && *p != '"')) return;
+    char *end = strchr(p + 1, *p);
+    char *close = end ? skip_word(end + 1, ")") : NULL;
+    if (!close || *close != '\0') return;
     
-    char *xpath_copy = strdup(xpath);
-    char *token = strtok(xpath_copy, "/");
-    XMLNode *current_context = root;
+    *end = '\0';
+    step->search = p + 1;
+    step->kind = token ? STEP_TOKEN : STEP_CONTAINS;
+}
+
+// Interpretar un paso (se modifica 'token': los nombres y el valor del
+// predicado apuntan dentro de él) e internar sus nombres en el plan
+static void compile_step(XPathPlan *plan, char *token, XPathPlanStep *step) {
+    step->any_name = 0;
+    step->name = SYMBOL_NONE;
+    step->attr_name = SYMBOL_NONE;
+    step->attr_value = NULL;
+    step->position = 0;
+    step->search = NULL;
+    
+    char *bracket = strchr(token, '[');
+    if (!bracket) {
+        if (strstr(token, "text()")) {
+            // Implementación básica: elementos <text>
+            step->kind = STEP_TEXT;
+            step->name = symbol_intern(&plan->names, "text", 4);
+        } else {
+            step->kind = STEP_ELEMENT;
+            compile_name_test(plan, token, step);
+        }
+        return;
+    }
+    
+    *bracket = '\0';
+    char *predicate = bracket + 1;
+    char *close = strrchr(predicate, ']');
+    if (!close) {
+        step->kind = STEP_INVALID;
+        return;
+    }
+    *close = '\0';
+    compile_name_test(plan, token, step);
     
-    // Manejar consulta absoluta
-    if (xpath[0] == '/') {
-        if (xpath[1] == '/') {
-            // Búsqueda descendiente (//)
-            token = strtok(NULL, "/");
-            if (token) {
-                find_by_element_name(root, token, result);
+    if (predicate[0] == '@') {
+        // Consulta con atributo: element[@attr='value']
+        step->kind = STEP_ATTRIBUTE;
+        char *attr_name = predicate + 1;
+        char *equals = strchr(attr_name, '=');
+        if (equals) {
+            *equals = '\0';
+            char *value = equals + 1;
+            // Remover comillas si existen
+            if (value[0] == '\'' || value[0] == '"') {
+                value++;
+            }
+            int len = strlen(value);
+            if (len > 0 && (value[len-1] == '\'' || value[len-1] == '"')) {
+                value[len-1] = '\0';
             }
-            free(xpath_copy);
-            return result;
+            step->attr_value = value;
         }
-        // Búsqueda desde raíz (/)
-        token = strtok(NULL, "/");
+        step->attr_name = symbol_intern(&plan->names, attr_name, strlen(attr_name));
+    } else if (strncmp(predicate, "contains", 8) == 0) {
+        compile_text_predicate(predicate, step);
+    } else if (strcmp(predicate, "last()") == 0) {
+        step->kind = STEP_POSITION;
+        step->position = XPATH_POSITION_LAST;
+    } else {
+        // Consulta con posición: element[1]
+        step->kind = STEP_POSITION;
+        step->position = atoi(predicate);
     }
+}
+
+// Compilar una consulta. Cada '/' da un paso por los hijos y cada '//' por los
+// descendientes; el primer paso de "/raiz/..." comprueba la raíz. Las consultas
+// relativas buscan en todo el documento, como "//"
+XPathPlan* xpath_compile(const char *xpath) {
+    XPathPlan *plan = (XPathPlan*)malloc(sizeof(XPathPlan));
+    plan->source = strdup(xpath);
+    plan->text = strdup(xpath);
+    plan->steps = NULL;
+    plan->step_count = 0;
+    init_symbol_table(&plan->names);
     
-    while (token) {
-        XPathResult *temp_result = init_xpath_result();
+    int capacity = 0;
+    int slashes = 0;
+    char *p = plan->text;
+    
+    while (*p) {
+        while (*p == '/') {
+            p++;
+            slashes++;
+        }
+        if (!*p) break;
         
-        // Verificar si es una consulta con predicado
-        if (strstr(token, "[@")) {
-            // Consulta con atributo: element[@attr='value']
-            char *element_name = strtok(token, "[");
-            char *predicate = strtok(NULL, "]");
-            
-            if (predicate && predicate[0] == '@') {
-                char *attr_part = predicate + 1;
-                char *attr_name = strtok(attr_part, "=");
-                char *attr_value = strtok(NULL, "'\"");
+        // El '/' que cierra el paso cuenta para el siguiente; dentro de un
+        // predicado o de comillas no separa pasos
+        char *token = p;
+        int next_slashes = 0;
+        int depth = 0;
+        char quote = 0;
+        while (*p && (*p != '/' || depth > 0 || quote)) {
+            if (quote) {
+                if (*p == quote) quote = 0;
+            } else if (*p == '\'' || *p == '"') {
+                quote = *p;
+            } else if (*p == '[') {
+                depth++;
+            } else if (*p == ']') {
+                depth--;
+            }
+            p++;
+        }
+        if (*p) {
+            *p++ = '\0';
+            next_slashes = 1;
+        }
+        
+        if (plan->step_count == capacity) {
+            capacity = capacity ? capacity * 2 : 4;
+            plan->steps = (XPathPlanStep*)realloc(plan->steps, capacity * sizeof(XPathPlanStep));
+        }
+        XPathPlanStep *step = &plan->steps[plan->step_count++];
+        compile_step(plan, token, step);
+        step->axis = slashes == 1 ? AXIS_CHILD : AXIS_DESCENDANT;
+        slashes = next_slashes;
+    }
+    return plan;
+}
+
+// Agregar texto a una cadena dinámica
+static void append_key(char **key, size_t *length, size_t *capacity, const char *text) {
+    size_t add = strlen(text);
+    if (*length + add + 1 > *capacity) {
+        while (*length + add + 1 > *capacity) *capacity *= 2;
+        *key = (char*)realloc(*key, *capacity);
+    }
+    memcpy(*key + *length, text, add + 1);
+    *length += add;
+}
+
+// Agregar un literal entre comillas simples; las comillas y las barras
+// invertidas del valor se escapan para que dos valores distintos no den la
+// misma clave
+static void append_quoted_key(char **key, size_t *length, size_t *capacity, const char *text) {
+    char c[3] = "";
+    append_key(key, length, capacity, "'");
+    for (const char *p = text; *p; p++) {
+        if (*p == '\'' || *p == '\\') {
+            c[0] = '\\';
+            c[1] = *p;
+        } else {
+            c[0] = *p;
+            c[1] = '\0';
+        }
+        append_key(key, length, capacity, c);
+    }
+    append_key(key, length, capacity, "'");
+}
+
+// Agregar un paso compilado con su eje explícito y su predicado en una sola
+// forma
+static void append_step_key(char **key, size_t *length, size_t *capacity, const XPathPlan *plan,
+                            const XPathPlanStep *step) {
+    char number[32];
+    append_key(key, length, capacity, step->axis == AXIS_CHILD ? "/" : "//");
+    
+    if (step->kind == STEP_INVALID) {
+        append_key(key, length, capacity, "[?]");
+        return;
+    }
+    if (step->kind == STEP_TEXT) {
+        append_key(key, length, capacity, "text()");
+        return;
+    }
+    append_key(key, length, capacity, step->any_name ? "*" : symbol_name(&plan->names, step->name));
+    
+    if (step->kind == STEP_ATTRIBUTE) {
+        append_key(key, length, capacity, "[@");
+        append_key(key, length, capacity, symbol_name(&plan->names, step->attr_name));
+        if (step->attr_value) {
+            append_key(key, length, capacity, "=");
+            append_quoted_key(key, length, capacity, step->attr_value);
+        }
+        append_key(key, length, capacity, "]");
+    } else if (step->kind == STEP_CONTAINS || step->kind == STEP_TOKEN) {
+        append_key(key, length, capacity, step->kind == STEP_TOKEN ? "[contains-token(text()," : "[contains(text(),");
+        append_quoted_key(key, length, capacity, step->search);
+        append_key(key, length, capacity, ")]");
+    } else if (step->kind == STEP_POSITION && step->position == XPATH_POSITION_LAST) {
+        append_key(key, length, capacity, "[last()]");
+    } else if (step->kind == STEP_POSITION) {
+        snprintf(number, sizeof(number), "[%d]", step->position);
+        append_key(key, length, capacity, number);
+    }
+}
+
+// Reconstruir la expresión desde los pasos compilados
+char* xpath_plan_key(const XPathPlan *plan) {
+    size_t length = 0, capacity = 64;
+    char *key = (char*)malloc(capacity);
+    key[0] = '\0';
+    
+    for (int i = 0; i < plan->step_count; i++) {
+        append_step_key(&key, &length, &capacity, plan, &plan->steps[i]);
+    }
+    return key;
+}
+
+void free_xpath_plan(XPathPlan *plan) {
+    if (plan) {
+        free(plan->source);
+        free(plan->text);
+        free(plan->steps);
+        free_symbol_table(&plan->names);
+        free(plan);
+    }
+}
+
+// Compilar las consultas de un archivo con una línea cada una
+XPathPlan** xpath_load_plans(const char *path, int *count, double *compile_seconds) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return NULL;
+    }
+
+    int capacity = 16;
+    XPathPlan **plans = (XPathPlan**)malloc(capacity * sizeof(XPathPlan*));
+    char line[512];
+    *count = 0;
+    *compile_seconds = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+
+        if (*count == capacity) {
+            capacity *= 2;
+            plans = (XPathPlan**)realloc(plans, capacity * sizeof(XPathPlan*));
+        }
+        double start = xml_time_now();
+        plans[(*count)++] = xpath_compile(line);
+        *compile_seconds += xml_time_now() - start;
+    }
+    fclose(file);
+    return plans;
+}
+
+// Liberar los planes de xpath_load_plans y su arreglo
+void free_xpath_plans(XPathPlan **plans, int count) {
+    for (int i = 0; i < count; i++) {
+        free_xpath_plan(plans[i]);
+    }
+    free(plans);
+}
+
+// Traducir los nombres del plan a IDs de la tabla de símbolos del documento
+// (SYMBOL_NONE si el nombre no aparece); el plan no se modifica
+static uint32_t* bind_plan_names(const XPathPlan *plan, const SymbolTable *names) {
+    uint32_t count = plan->names.count;
+    uint32_t *ids = (uint32_t*)malloc((count ? count : 1) * sizeof(uint32_t));
+    for (uint32_t id = 0; id < count; id++) {
+        ids[id] = symbol_lookup(names, plan->names.names[id]);
+    }
+    return ids;
+}
+
+static uint32_t bound_id(const uint32_t *ids, uint32_t plan_id) {
+    return plan_id == SYMBOL_NONE ? SYMBOL_NONE : ids[plan_id];
+}
+
+// Agregar de una vez una lista de nodos del índice
+static void add_nodes_to_result(XPathResult *result, XMLNode **nodes, size_t count) {
+    if (count == 0) return;
+    
+    if (result->capacity < result->count + (int)count) {
+        result->capacity = result->count + (int)count;
+        result->nodes = (XMLNode**)realloc(result->nodes, result->capacity * sizeof(XMLNode*));
+    }
+    memcpy(result->nodes + result->count, nodes, count * sizeof(XMLNode*));
+    result->count += (int)count;
+}
+
+// ¿Está construido y al día el índice? (built y version de ElementIndex o
+// AttributeIndex)
+static int index_current(const XMLDocument *doc, int built, unsigned long version) {
+    return built && version == doc->version;
+}
+
+// ¿Tiene el paso un predicado que se comprueba en cada elemento?
+static int step_has_predicate(const XPathPlanStep *step) {
+    return step->kind == STEP_ATTRIBUTE || step->kind == STEP_CONTAINS || step->kind == STEP_TOKEN;
+}
+
+// Forma de obtener los candidatos de un paso
+typedef enum {
+    ACCESS_NONE,        // Ningún elemento puede cumplir el paso
+    ACCESS_SCAN,        // Recorrido del árbol
+    ACCESS_CHILDREN,    // Hijos de los nodos del contexto
+    ACCESS_NAME,        // Índice de nombres
+    ACCESS_ATTRIBUTE,   // Índice de atributos
+    ACCESS_TEXT         // Índice de texto
+} StepAccess;
+
+static const char *access_names[] = {
+    "sin resultados", "recorrido del árbol", "hijos del contexto",
+    "índice de nombres", "índice de atributos", "índice de texto"
+};
+
+// Costes en nodos visitados. Comprobar un predicado cuesta más que leer un
+// candidato de una lista, y un índice que aún no está construido suma su
+// construcción (un recorrido del árbol; el de texto, varios) repartida entre
+// las consultas que se espera que lo aprovechen
+#define COST_ATTRIBUTE_CHECK 2.0
+#define COST_TEXT_CHECK 8.0
+#define COST_TEXT_BUILD 4.0
+#define COST_INDEX_REUSE 8.0
+
+// Fracción de elementos que se supone que cumplen un predicado cuando no hay
+// estadísticas (los de texto nunca las tienen)
+#define SELECTIVITY_ATTRIBUTE 0.1
+#define SELECTIVITY_ATTRIBUTE_VALUE 0.01
+#define SELECTIVITY_TEXT 0.1
+
+// Plan de un paso: el acceso de menor coste y las filas que se esperan
+typedef struct StepChoice {
+    StepAccess access;
+    int filter;             // El predicado se comprueba en cada candidato
+    double named;           // Elementos del documento que pasan la prueba de nombre
+    double rows;            // Filas estimadas del paso
+    double cost;
+} StepChoice;
+
+// Tabla semántica del documento, si es de su versión actual
+static const SemanticTable* document_statistics(const XMLDocument *doc) {
+    return doc->statistics && doc->statistics_version == doc->version ? doc->statistics : NULL;
+}
+
+// Elementos con el atributo del paso (y su valor) según una entrada de la
+// tabla: elementos con el atributo entre valores distintos
+static double entry_attribute_rows(const SemanticEntry *entry, uint32_t attr_id, const char *value) {
+    for (int i = 0; i < entry->attr_count; i++) {
+        if (entry->attribute_ids[i] != attr_id) continue;
+        double rows = entry->attribute_counts[i];
+        return value ? rows / semantic_distinct_values(entry, i) : rows;
+    }
+    return 0;
+}
+
+// Planificar un paso con 'context_count' nodos de contexto (-1 = el
+// documento). Las cuentas son exactas si el índice está al día y si no salen
+// de la tabla semántica; sin ella se suponen selectividades fijas. Cada acceso
+// posible recibe un coste y se elige el menor: así la prueba más selectiva
+// (nombre, atributo o texto) produce los candidatos y la otra los filtra.
+// 'context_rows' y 'context_named' (filas estimadas del paso anterior y
+// elementos con su nombre) dan las filas estimadas del paso suponiendo que
+// el contexto reparte los candidatos por igual. 'previous' es el paso que
+// produjo el contexto (NULL para el primero). Con 'lazy' solo se usan los
+// índices ya construidos, y 'flat' indica si el contexto es plano
+static void plan_step(XMLDocument *doc, const XPathPlanStep *step, const XPathPlanStep *previous,
+                      const uint32_t *ids, int context_count, double context_rows, double context_named,
+                      int lazy, int flat, StepChoice *choice) {
+    uint32_t name_id = bound_id(ids, step->name);
+    uint32_t attr_id = bound_id(ids, step->attr_name);
+    const SemanticTable *table = document_statistics(doc);
+    int names_current = index_current(doc, doc->element_index.built, doc->element_index.version);
+    int attrs_current = index_current(doc, doc->attribute_index.built, doc->attribute_index.version);
+    int text_current = index_current(doc, doc->text_index.built, doc->text_index.version);
+    int text_step = step->kind == STEP_CONTAINS || step->kind == STEP_TOKEN;
+    size_t count;
+    
+    memset(choice, 0, sizeof(StepChoice));
+    choice->access = ACCESS_NONE;
+    if (step->kind == STEP_INVALID || (!step->any_name && name_id == SYMBOL_NONE) ||
+        (step->kind == STEP_ATTRIBUTE && attr_id == SYMBOL_NONE)) {
+        return;
+    }
+    
+    double nodes = 0;
+    for (XMLNode *node = doc->root; node; node = node->next) {
+        nodes += node->size;
+    }
+    double elements = table ? table->total_elements : names_current ? doc->element_index.node_count : nodes;
+    
+    // Elementos con el nombre del paso
+    double named = elements;
+    if (!step->any_name && names_current) {
+        xml_elements_by_name(doc, name_id, &count);
+        named = count;
+    } else if (!step->any_name && table) {
+        SemanticEntry *entry = name_id < table->entries_by_id_size ? table->entries_by_id[name_id] : NULL;
+        named = entry ? entry->count : 0;
+    } else if (!step->any_name) {
+        named = elements / (doc->names.count ? doc->names.count : 1);
+    }
+    
+    // Elementos que cumplen el predicado: de cualquier nombre ('listed', la
+    // lista de su índice) y con el nombre del paso ('matching')
+    double listed = 0, matching = named;
+    if (step->kind == STEP_ATTRIBUTE) {
+        if (table) {
+            for (SemanticEntry *entry = table->entries; entry; entry = entry->next) {
+                listed += entry_attribute_rows(entry, attr_id, step->attr_value);
+            }
+            if (!step->any_name) {
+                SemanticEntry *entry = name_id < table->entries_by_id_size ? table->entries_by_id[name_id] : NULL;
+                matching = entry ? entry_attribute_rows(entry, attr_id, step->attr_value) : 0;
+            } else {
+                matching = listed;
+            }
+        } else {
+            listed = elements * (step->attr_value ? SELECTIVITY_ATTRIBUTE_VALUE : SELECTIVITY_ATTRIBUTE);
+        }
+        if (attrs_current) {
+            xml_elements_with_attribute(doc, attr_id, step->attr_value, &count);
+            listed = count;
+        }
+        if (!table) matching = listed * named / (elements > 0 ? elements : 1);
+    } else if (text_step) {
+        listed = elements * SELECTIVITY_TEXT;
+        matching = named * SELECTIVITY_TEXT;
+    }
+    
+    // Filas: las del nombre y el predicado, en la parte del documento que
+    // cubre el contexto. [n] y [last()] dan como mucho una por padre
+    double rows = matching;
+    if (context_count < 0) {
+        if (step->axis == AXIS_CHILD && rows > 1) rows = 1;
+    } else if (context_named > 0 && context_rows < context_named) {
+        rows *= context_rows / context_named;
+    }
+    if (step->kind == STEP_POSITION && context_count >= 0 && step->axis == AXIS_CHILD && rows > context_rows) {
+        rows = context_rows;
+    }
+    choice->named = named;
+    choice->rows = rows > 0 && rows < 1 ? 1 : rows;
+    
+    // Costes de los accesos posibles; la unión estructural con el contexto
+    // recorre además sus nodos
+    double join = context_count > 0 ? context_count : 0;
+    double check = step->kind == STEP_ATTRIBUTE ? COST_ATTRIBUTE_CHECK : text_step ? COST_TEXT_CHECK : 0;
+    double build = nodes / COST_INDEX_REUSE;
+    
+    choice->access = ACCESS_SCAN;
+    choice->filter = 1;
+    choice->cost = nodes + named * check + join;
+    if (context_count < 0 && step->axis == AXIS_CHILD) {
+        choice->cost = 1 + check;       // Del documento solo se llega a la raíz
+    }
+    
+    if (context_count >= 0 && step->axis == AXIS_CHILD) {
+        // Hijos por nodo: los de los elementos con el nombre del contexto
+        // según la tabla, o la media (todo nodo salvo la raíz es hijo de un
+        // elemento). Con un contexto anidado los hijos encontrados se
+        // ordenan después
+        double fanout = elements > 0 ? (nodes - 1) / elements : 0;
+        uint32_t parent_id = previous && !previous->any_name ? bound_id(ids, previous->name) : SYMBOL_NONE;
+        SemanticEntry *parent = table && parent_id < table->entries_by_id_size ? table->entries_by_id[parent_id] : NULL;
+        if (parent && parent->count > 0) {
+            fanout = (double)parent->child_count / parent->count;
+        }
+        double found = context_count * fanout * named / (elements > 0 ? elements : 1);
+        double visited = context_count * fanout;
+        if (step->kind == STEP_POSITION && step->position != XPATH_POSITION_LAST && found > 0) {
+            // [n] deja cada padre en el n-ésimo hijo que pasa la prueba
+            double reached = (double)step->position * context_count / found;
+            if (reached < 1) visited *= reached;
+            if (found > context_count) found = context_count;
+        }
+        double cost = visited + found * check;
+        if (!flat && context_count > 1) {
+            int levels = 1;
+            for (double n = found; n > 2; n /= 2) levels++;
+            cost += found * levels;
+        }
+        if (cost < choice->cost) {
+            choice->access = ACCESS_CHILDREN;
+            choice->cost = cost;
+        }
+    }
+    if (!step->any_name && (!lazy || names_current)) {
+        double cost = named + named * check + join + (names_current ? 0 : build);
+        if (cost < choice->cost) {
+            choice->access = ACCESS_NAME;
+            choice->filter = step_has_predicate(step);
+            choice->cost = cost;
+        }
+    }
+    if (step->kind == STEP_ATTRIBUTE && (!lazy || attrs_current)) {
+        double cost = listed + join + (attrs_current ? 0 : build);
+        if (cost < choice->cost) {
+            choice->access = ACCESS_ATTRIBUTE;
+            choice->filter = 0;
+            choice->cost = cost;
+        }
+    }
+    if (text_step && (!lazy || text_current)) {
+        double cost = listed * COST_TEXT_CHECK + join + (text_current ? 0 : build * COST_TEXT_BUILD);
+        if (cost < choice->cost) {
+            choice->access = ACCESS_TEXT;
+            choice->filter = 0;
+            choice->cost = cost;
+        }
+    }
+}
+
+// Candidatos del índice elegido, en orden de documento. La lista del índice
+// de texto se guarda en 'owned', que la libera
+static XMLNode** step_candidates(XMLDocument *doc, const XPathPlanStep *step, StepAccess access,
+                                 uint32_t name_id, uint32_t attr_id, size_t *count, XPathResult *owned) {
+    *count = 0;
+    if (access == ACCESS_NAME) {
+        return xml_elements_by_name(doc, name_id, count);
+    }
+    if (access == ACCESS_ATTRIBUTE) {
+        return xml_elements_with_attribute(doc, attr_id, step->attr_value, count);
+    }
+    
+    XMLNode **by_text = xml_elements_containing_text(doc, step->search, step->kind == STEP_TOKEN, count);
+    owned->nodes = by_text;
+    owned->count = (int)*count;
+    owned->capacity = (int)*count;
+    return by_text;
+}
+
+// ¿Tiene el elemento el atributo del predicado (con su valor, si lo hay)?
+static int has_attribute(XMLNode *node, uint32_t attr_id, const char *attr_value) {
+    if (!node->attributes) return 0;
+    for (Attribute *attr = node->attributes->first; attr; attr = attr->next) {
+        if (attr->name_id == attr_id && (!attr_value || strcmp(attr->value, attr_value) == 0)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// ¿Tiene el elemento un hijo de texto o CDATA que contiene la búsqueda?
+static int has_text(XMLNode *node, const char *search, int token) {
+    for (XMLNode *child = node->children; child; child = child->next) {
+        if ((child->type == NODE_TEXT || child->type == NODE_CDATA) && child->content &&
+            xml_text_contains(child->content, search, token)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// ¿Cumple el elemento el predicado de atributo o de texto del paso?
+static int step_predicate(const XPathPlanStep *step, XMLNode *node, uint32_t attr_id) {
+    if (step->kind == STEP_ATTRIBUTE) return has_attribute(node, attr_id, step->attr_value);
+    if (step->kind == STEP_CONTAINS || step->kind == STEP_TOKEN) {
+        return has_text(node, step->search, step->kind == STEP_TOKEN);
+    }
+    return 1;
+}
+
+// ¿Cumple el elemento la prueba de nombre y el predicado del paso?
+static int step_matches(const XPathPlanStep *step, XMLNode *node, uint32_t name_id, uint32_t attr_id) {
+    if (node->type != NODE_ELEMENT) return 0;
+    if (!step->any_name && node->name_id != name_id) return 0;
+    return step_predicate(step, node, attr_id);
+}
+
+// [last()]: ¿ningún hermano siguiente pasa la prueba de nombre? Cada búsqueda
+// se detiene en el siguiente que la pasa, así que para todos los candidatos
+// de un padre se recorren sus hijos una sola vez
+static int is_last_match(const XPathPlanStep *step, XMLNode *node, uint32_t name_id) {
+    for (XMLNode *sibling = node->next; sibling; sibling = sibling->next) {
+        if (sibling->type == NODE_ELEMENT && (step->any_name || sibling->name_id == name_id)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Paso por los hijos de cada nodo del contexto. Si el contexto es plano
+// (ningún nodo dentro de otro) los hijos salen ya en orden de documento y,
+// si no, se ordenan por su número; la posición se cuenta por padre sin tablas
+static void evaluate_children(const XPathPlanStep *step, uint32_t name_id, uint32_t attr_id,
+                              XPathResult *context, int flat, XPathResult *result) {
+    for (int i = 0; i < context->count; i++) {
+        int position = 0;
+        for (XMLNode *child = context->nodes[i]->children; child; child = child->next) {
+            if (!step_matches(step, child, name_id, attr_id)) continue;
+            if (step->kind == STEP_POSITION) {
+                if (step->position == XPATH_POSITION_LAST) {
+                    if (!is_last_match(step, child, name_id)) continue;
+                    add_to_result(result, child);
+                    break;
+                }
+                if (++position < step->position) continue;
+                if (position == step->position) add_to_result(result, child);
+                break;
+            }
+            add_to_result(result, child);
+        }
+    }
+    
+    if (!flat) {
+        size_t count = result->count;
+        xml_sort_document_order(result->nodes, &count);
+        result->count = (int)count;
+    }
+}
+
+// Forma en que se producen los nodos de un paso
+typedef enum {
+    JOIN_LIST,          // Lista ya resuelta en orden de documento
+    JOIN_CHILDREN,      // Hijos de un contexto plano
+    JOIN_CANDIDATES     // Candidatos unidos con los rangos del contexto
+} StepJoinMode;
+
+// Evaluación de un paso en curso: produce los nodos del resultado de uno en
+// uno y en orden de documento, así que puede dejarse a medias. evaluate_step
+// la lleva hasta el final y los cursores solo hasta donde se les pide. El
+// contexto es una lista ya resuelta o, en un cursor, el paso anterior, al
+// que se le pide cada nodo cuando hace falta
+typedef struct StepJoin {
+    StepJoinMode mode;
+    XMLDocument *doc;
+    const XPathPlanStep *step;
+    uint32_t name_id;
+    uint32_t attr_id;
+    XPathResult *context;           // NULL sin 'source' = el documento
+    struct StepJoin *source;        // Paso anterior que produce el contexto
+    XMLNode *ahead;                 // Nodo ya pedido a 'source' y aún sin usar
+    int source_done;
+    
+    XMLNode **nodes;                // Lista o candidatos de los índices
+    size_t count;
+    size_t index;
+    XPathResult owned;              // Lista propia (índice de texto o hijos de un contexto anidado)
+    int filter;                     // Comprobar el predicado en cada candidato
+    int walking;                    // Candidatos del recorrido del árbol
+    XMLTreeWalker walker;
+    XMLNode *cover;                 // Nodo del contexto cuyo subárbol se recorre o, en el
+                                    // descendiente, que contiene a los candidatos
+    
+    XMLNode **open;                 // Nodos del contexto abiertos, del más externo al más interno
+    int open_count;
+    int open_capacity;
+    int next;                       // Siguiente nodo del contexto por abrir o por recorrer
+    
+    // Posiciones: padres de los candidatos aún abiertos, con su contador. Como
+    // los candidatos llegan en orden de documento, los padres se anidan igual
+    // que el contexto y basta otra pila
+    XMLNode **parents;
+    int *positions;
+    int parent_count;
+    int parent_capacity;
+    
+    XMLNode *child;                 // JOIN_CHILDREN: próximo hijo por probar
+    int position;
+} StepJoin;
+
+#define JOIN_NO_LIMIT UINT32_MAX    // step_join_next sin cota
+
+static XMLNode* step_join_next(StepJoin *join, uint32_t limit);
+
+// Nodo 'next' del contexto (NULL si no quedan). Con 'source' se pide al paso
+// anterior la primera vez y se guarda hasta que se avanza; si no hay ninguno
+// antes de 'limit' puede devolver NULL sin que el paso anterior siga buscando
+static XMLNode* context_node(StepJoin *join, int next, uint32_t limit) {
+    if (!join->source) {
+        return next < join->context->count ? join->context->nodes[next] : NULL;
+    }
+    if (!join->ahead && !join->source_done) {
+        join->ahead = step_join_next(join->source, limit);
+        join->source_done = !join->ahead && limit == JOIN_NO_LIMIT;
+    }
+    return join->ahead;
+}
+
+// Primer candidato desde 'index' posterior a 'pre' (búsqueda binaria: los
+// candidatos están en orden de documento)
+static size_t skip_candidates(XMLNode **nodes, size_t index, size_t count, uint32_t pre) {
+    while (index < count) {
+        size_t middle = index + (count - index) / 2;
+        if (nodes[middle]->pre <= pre) {
+            index = middle + 1;
+        } else {
+            count = middle;
+        }
+    }
+    return index;
+}
+
+// Preparar un paso sobre todo el contexto con el acceso elegido por
+// plan_step. Los candidatos de un índice o del recorrido se unen con el
+// contexto: los dos están en orden de documento, así que una pasada con una
+// pila de los nodos del contexto cuyo rango [pre, pre + size) contiene al
+// candidato decide el eje en O(1) por nodo. El resultado sale ordenado y sin
+// duplicados en tiempo proporcional a las dos listas, sin recorrer el árbol
+// por cada nodo del contexto; el recorrido, si no hay índice, solo baja por
+// los subárboles del contexto. '*flat' indica si el contexto es plano y se
+// actualiza. Con 'source' el contexto es ese paso en curso
+static void step_join_init(StepJoin *join, XMLDocument *doc, const XPathPlanStep *step, const uint32_t *ids,
+                           XPathResult *context, StepJoin *source, int *flat, const StepChoice *choice) {
+    memset(join, 0, sizeof(StepJoin));
+    join->mode = JOIN_LIST;
+    join->doc = doc;
+    join->step = step;
+    join->context = context;
+    join->source = source;
+    if (choice->access == ACCESS_NONE) return;
+    
+    int has_context = context || source;
+    join->name_id = bound_id(ids, step->name);
+    join->attr_id = bound_id(ids, step->attr_name);
+    join->filter = choice->filter;
+    
+    // Por los hijos se recorren directamente los del contexto; con una lista
+    // anidada se reúnen y se ordenan antes. Un paso anterior anidado no se
+    // reúne: sus subárboles se recorren como en un barrido
+    if (context && context->count == 1) *flat = 1;
+    if (choice->access == ACCESS_CHILDREN && (*flat || !source)) {
+        if (*flat) {
+            join->mode = JOIN_CHILDREN;
+        } else {
+            evaluate_children(step, join->name_id, join->attr_id, context, 0, &join->owned);
+            join->nodes = join->owned.nodes;
+            join->count = join->owned.count;
+        }
+        return;
+    }
+    if (!has_context || step->axis != AXIS_CHILD) *flat = !has_context && step->axis == AXIS_CHILD;
+    
+    join->mode = JOIN_CANDIDATES;
+    if (choice->access == ACCESS_SCAN || choice->access == ACCESS_CHILDREN) {
+        if (!has_context && step->axis == AXIS_CHILD) {
+            // Del documento solo se llega a la raíz: no hace falta recorrer
+            join->nodes = &doc->root;
+            join->count = 1;
+        } else {
+            join->walking = 1;
+            if (!has_context) xml_walker_init_list(&join->walker, doc->root);
+        }
+    } else {
+        join->nodes = step_candidates(doc, step, choice->access, join->name_id, join->attr_id,
+                                      &join->count, &join->owned);
+        
+        // '//nombre' desde el documento: la lista entera, si ya cumple las
+        // dos pruebas (las de atributos y de texto tienen elementos de todos
+        // los nombres)
+        if (!has_context && step->axis == AXIS_DESCENDANT && !join->filter && step->kind != STEP_POSITION &&
+            (step->any_name || choice->access == ACCESS_NAME)) {
+            join->mode = JOIN_LIST;
+            return;
+        }
+    }
+}
+
+// Siguiente hijo de un contexto plano; la posición se cuenta por padre y, al
+// encontrarla, se pasa al siguiente nodo del contexto
+static XMLNode* next_child(StepJoin *join, uint32_t limit) {
+    const XPathPlanStep *step = join->step;
+    
+    while (1) {
+        while (!join->child) {
+            XMLNode *parent = context_node(join, join->next, limit);
+            if (!parent || parent->pre >= limit) return NULL;
+            join->next++;
+            join->ahead = NULL;
+            join->child = parent->children;
+            join->position = 0;
+        }
+        if (join->child->pre >= limit) return NULL;
+        XMLNode *child = join->child;
+        join->child = child->next;
+        if (!step_matches(step, child, join->name_id, join->attr_id)) continue;
+        
+        if (step->kind == STEP_POSITION) {
+            if (step->position == XPATH_POSITION_LAST) {
+                if (!is_last_match(step, child, join->name_id)) continue;
+            } else {
+                if (++join->position < step->position) continue;
+                if (join->position != step->position) {
+                    join->child = NULL;
+                    continue;
+                }
+            }
+            join->child = NULL;
+        }
+        return child;
+    }
+}
+
+// Siguiente candidato que cumple el predicado, el eje y la posición. El
+// estado de las pilas se lleva en variables locales y se guarda al salir
+static XMLNode* next_candidate(StepJoin *join, uint32_t limit) {
+    const XPathPlanStep *step = join->step;
+    int has_context = join->context || join->source;
+    size_t index = join->index;
+    XMLNode **open = join->open;
+    int open_count = join->open_count;
+    int next = join->next;
+    int parent_count = join->parent_count;
+    XMLNode *found = NULL;
+    
+    while (!found) {
+        XMLNode *node;
+        if (join->walking) {
+            if (join->walker.node && join->walker.node->pre >= limit) break;
+            node = xml_walker_next(&join->walker);
+            if (!node) {
+                if (!has_context) break;
                 
-                if (attr_value) {
-                    // Remover comillas si existen
-                    if (attr_value[0] == '\'' || attr_value[0] == '"') {
-                        attr_value++;
-                    }
-                    int len = strlen(attr_value);
-                    if (len > 0 && (attr_value[len-1] == '\'' || attr_value[len-1] == '"')) {
-                        attr_value[len-1] = '\0';
+                // Subárbol terminado: los nodos del contexto que quedaban
+                // dentro ya están recorridos; se sigue por el siguiente
+                XMLNode *cover = join->cover;
+                XMLNode *start;
+                while ((start = context_node(join, next, limit)) && cover && start->pre < cover->pre + cover->size) {
+                    next++;
+                    join->ahead = NULL;
+                }
+                if (!start || start->pre >= limit) break;
+                join->cover = start;
+                xml_walker_init(&join->walker, start);
+                continue;
+            }
+            if (!step_matches(step, node, join->name_id, join->attr_id)) continue;
+        } else {
+            if (has_context && step->axis == AXIS_CHILD && open_count == 0) {
+                // Sin nodos abiertos, los candidatos anteriores al siguiente
+                // nodo del contexto no están en su rango
+                XMLNode *start = context_node(join, next, limit);
+                if (!start) break;
+                if (index < join->count && join->nodes[index]->pre <= start->pre) {
+                    index = skip_candidates(join->nodes, index, join->count, start->pre);
+                }
+            }
+            if (index >= join->count || join->nodes[index]->pre >= limit) break;
+            node = join->nodes[index++];
+            if (!step->any_name && node->name_id != join->name_id) continue;
+            if (join->filter && !step_predicate(step, node, join->attr_id)) continue;
+        }
+        
+        // Eje: del documento solo se llega a la raíz por '/'
+        XMLNode *parent = node->parent;
+        if (!has_context) {
+            if (step->axis == AXIS_CHILD && node != join->doc->root) continue;
+        } else if (step->axis == AXIS_DESCENDANT) {
+            // Para los descendientes basta el nodo del contexto más externo
+            // que contiene al candidato: los anidados en él no cambian nada,
+            // así que no se piden hasta salir de su rango
+            XMLNode *cover = join->cover;
+            if (join->walking) {
+                if (node == cover) continue;
+            } else if (!cover || !xml_is_ancestor(cover, node)) {
+                XMLNode *start;
+                while ((start = context_node(join, next, limit)) &&
+                       ((cover && start->pre < cover->pre + cover->size) || start->pre + start->size <= node->pre)) {
+                    next++;
+                    join->ahead = NULL;
+                }
+                if (!start || start->pre >= limit) break;
+                next++;
+                join->ahead = NULL;
+                join->cover = start;
+                if (!xml_is_ancestor(start, node)) {
+                    if (index < join->count && join->nodes[index]->pre <= start->pre) {
+                        index = skip_candidates(join->nodes, index, join->count, start->pre);
                     }
+                    continue;
                 }
-                
-                find_by_attribute(current_context, attr_name, attr_value, temp_result);
             }
-        } else if (strstr(token, "[") && strstr(token, "]")) {
-            // Consulta con posición: element[1]
-            char *element_name = strtok(token, "[");
-            char *position_str = strtok(NULL, "]");
-            int position = atoi(position_str);
+        } else {
+            // Abrir los nodos del contexto anteriores al candidato y cerrar
+            // los que ya no lo contienen (los rangos se anidan o son disjuntos)
+            XMLNode *opened;
+            while ((opened = context_node(join, next, node->pre)) && opened->pre < node->pre) {
+                next++;
+                join->ahead = NULL;
+                while (open_count > 0 && !xml_is_ancestor(open[open_count - 1], opened)) open_count--;
+                if (open_count == join->open_capacity) {
+                    join->open_capacity = join->open_capacity ? join->open_capacity * 2 : 16;
+                    join->open = (XMLNode**)realloc(join->open, join->open_capacity * sizeof(XMLNode*));
+                    open = join->open;
+                }
+                open[open_count++] = opened;
+            }
+            while (open_count > 0 && !xml_is_ancestor(open[open_count - 1], node)) open_count--;
+            if (open_count == 0) continue;
             
-            find_by_position(current_context, element_name, position, temp_result);
-        } else if (strstr(token, "text()")) {
-            // Consulta de texto: contains(text(), 'value')
-            // Implementación básica
-            find_by_element_name(current_context, "text", temp_result);
+            // El más interno es el antecesor más cercano en el contexto
+            if (open[open_count - 1]->depth + 1 != node->depth) continue;
+        }
+        
+        // Posición entre los hermanos del mismo nombre
+        if (step->kind == STEP_POSITION && step->position == XPATH_POSITION_LAST) {
+            if (!is_last_match(step, node, join->name_id)) continue;
+        } else if (step->kind == STEP_POSITION) {
+            int position = 1;
+            if (parent) {
+                while (parent_count > 0 && !xml_is_ancestor(join->parents[parent_count - 1], node)) parent_count--;
+                if (parent_count == 0 || join->parents[parent_count - 1] != parent) {
+                    if (parent_count == join->parent_capacity) {
+                        join->parent_capacity = join->parent_capacity ? join->parent_capacity * 2 : 16;
+                        join->parents = (XMLNode**)realloc(join->parents, join->parent_capacity * sizeof(XMLNode*));
+                        join->positions = (int*)realloc(join->positions, join->parent_capacity * sizeof(int));
+                    }
+                    join->parents[parent_count] = parent;
+                    join->positions[parent_count++] = 0;
+                }
+                position = ++join->positions[parent_count - 1];
+            }
+            if (position != step->position) continue;
+        }
+        found = node;
+    }
+    
+    join->index = index;
+    join->open_count = open_count;
+    join->next = next;
+    join->parent_count = parent_count;
+    return found;
+}
+
+// Siguiente nodo del paso (NULL al terminar). Con 'limit' también devuelve
+// NULL, sin perder nada, en cuanto sabe que el siguiente no es anterior a ese
+// pre: así quien une un contexto no hace recorrer a este paso más allá del
+// candidato que está probando
+static XMLNode* step_join_next(StepJoin *join, uint32_t limit) {
+    if (join->mode == JOIN_LIST) {
+        if (join->index >= join->count || join->nodes[join->index]->pre >= limit) return NULL;
+        return join->nodes[join->index++];
+    }
+    if (join->mode == JOIN_CHILDREN) {
+        return next_child(join, limit);
+    }
+    return next_candidate(join, limit);
+}
+
+static void free_step_join(StepJoin *join) {
+    free(join->open);
+    free(join->parents);
+    free(join->positions);
+    free(join->owned.nodes);
+}
+
+// Evaluar un paso completo sobre todo el contexto (NULL = el documento, cuyo
+// único hijo es la raíz) con el acceso elegido
+static XPathResult* evaluate_step(XMLDocument *doc, const XPathPlanStep *step, const uint32_t *ids,
+                                  XPathResult *context, int *flat, const StepChoice *choice) {
+    XPathResult *result = init_xpath_result();
+    StepJoin join;
+    step_join_init(&join, doc, step, ids, context, NULL, flat, choice);
+    
+    if (join.mode == JOIN_LIST) {
+        add_nodes_to_result(result, join.nodes, join.count);
+    } else {
+        XMLNode *node;
+        while ((node = step_join_next(&join, JOIN_NO_LIMIT))) {
+            add_to_result(result, node);
+        }
+    }
+    
+    free_step_join(&join);
+    return result;
+}
+
+// Número de pasos iniciales que forman un camino de solo hijos con nombre
+// desde la raíz
+static int leading_path_length(const XPathPlan *plan) {
+    int length = 0;
+    while (length < plan->step_count) {
+        const XPathPlanStep *step = &plan->steps[length];
+        if (step->axis != AXIS_CHILD || step->any_name ||
+            (step->kind != STEP_ELEMENT && step->kind != STEP_TEXT)) {
+            break;
+        }
+        length++;
+    }
+    return length;
+}
+
+// Evaluar los pasos [0, end) del plan: cada paso parte del conjunto completo
+// de nodos del anterior. Devuelve el conjunto del último (NULL si end es 0:
+// el contexto sigue siendo el documento)
+static XPathResult* evaluate_steps(const XPathPlan *plan, XMLDocument *doc, const uint32_t *ids,
+                                   int end, int *flat) {
+    XPathResult *context = NULL;
+    
+    // Los primeros pasos "/a/b/c" (hijos con nombre desde la raíz) se
+    // resuelven con una búsqueda en el resumen de caminos
+    int first = leading_path_length(plan);
+    if (first > end) first = end;
+    if (first > 0) {
+        uint32_t *names = (uint32_t*)malloc(first * sizeof(uint32_t));
+        for (int i = 0; i < first; i++) {
+            names[i] = bound_id(ids, plan->steps[i].name);
+        }
+        size_t count;
+        XMLNode **nodes = xml_elements_by_path(doc, names, first, &count);
+        free(names);
+        
+        context = init_xpath_result();
+        add_nodes_to_result(context, nodes, count);
+        if (context->count == 0) return context;
+    }
+    
+    for (int i = first; i < end; i++) {
+        StepChoice choice;
+        plan_step(doc, &plan->steps[i], i > 0 ? &plan->steps[i - 1] : NULL, ids, context ? context->count : -1,
+                  0, 0, 0, *flat, &choice);
+        XPathResult *next = evaluate_step(doc, &plan->steps[i], ids, context, flat, &choice);
+        free_xpath_result(context);
+        context = next;
+        if (context->count == 0) break;
+    }
+    return context;
+}
+
+// Ejecutar un plan: el resultado es el conjunto del último paso
+XPathResult* xpath_execute(const XPathPlan *plan, XMLDocument *doc) {
+    if (!doc->root || plan->step_count == 0) return init_xpath_result();
+    
+    xml_number_nodes(doc);
+    uint32_t *ids = bind_plan_names(plan, &doc->names);
+    int flat = 1;
+    XPathResult *result = evaluate_steps(plan, doc, ids, plan->step_count, &flat);
+    free(ids);
+    return result;
+}
+
+// Acceso de un paso en EXPLAIN: el índice o recorrido, la unión con el
+// contexto y las pruebas que se comprueban en cada candidato
+static void print_step_access(const XPathPlanStep *step, const StepChoice *choice, int joined) {
+    printf("[%s", access_names[choice->access]);
+    if (joined && choice->access != ACCESS_CHILDREN && choice->access != ACCESS_NONE) {
+        printf(" + unión estructural");
+    }
+    if (!step->any_name && (choice->access == ACCESS_ATTRIBUTE || choice->access == ACCESS_TEXT)) {
+        printf(", filtra el nombre");
+    }
+    if (choice->filter && step_has_predicate(step)) {
+        printf(", filtra el predicado");
+    }
+    if (step->kind == STEP_POSITION && choice->access != ACCESS_NONE) {
+        printf(", posición");
+    }
+    printf("]\n");
+}
+
+// EXPLAIN: el acceso elegido para cada paso con su coste, y las filas
+// estimadas frente a las reales. Los pasos se ejecutan como en xpath_execute
+void print_xpath_explain(const XPathPlan *plan, XMLDocument *doc) {
+    printf("Plan de %s\n", plan->source);
+    if (!doc->root || plan->step_count == 0) {
+        printf("  Sin pasos que ejecutar\n");
+        return;
+    }
+    
+    xml_number_nodes(doc);
+    uint32_t *ids = bind_plan_names(plan, &doc->names);
+    printf("Estadísticas: %s\n", document_statistics(doc) ? "tabla semántica del documento"
+                                                           : "índices construidos y selectividades fijas");
+    printf("  Paso     Estimadas       Reales        Coste   Tiempo (ms)   Paso y acceso\n");
+    
+    XPathResult *context = NULL;
+    double rows = 0, named = 0;
+    int flat = 1;
+    char *key = (char*)malloc(64);
+    size_t length, capacity = 64;
+    
+    // Los primeros pasos, del resumen de caminos
+    int first = leading_path_length(plan);
+    if (first > 0) {
+        uint32_t *names = (uint32_t*)malloc(first * sizeof(uint32_t));
+        length = 0;
+        key[0] = '\0';
+        for (int i = 0; i < first; i++) {
+            StepChoice choice;
+            plan_step(doc, &plan->steps[i], i > 0 ? &plan->steps[i - 1] : NULL, ids, i == 0 ? -1 : (int)rows,
+                      rows, named, 0, 1, &choice);
+            rows = choice.rows;
+            named = choice.named;
+            names[i] = bound_id(ids, plan->steps[i].name);
+            append_step_key(&key, &length, &capacity, plan, &plan->steps[i]);
+        }
+        
+        double start = xml_time_now();
+        size_t count;
+        XMLNode **nodes = xml_elements_by_path(doc, names, first, &count);
+        context = init_xpath_result();
+        add_nodes_to_result(context, nodes, count);
+        double elapsed = xml_time_now() - start;
+        free(names);
+        
+        char label[16];
+        snprintf(label, sizeof(label), first > 1 ? "1-%d" : "%d", first);
+        printf("  %4s  %12.0f %12d %12s  %12.3f   %s [resumen de caminos]\n", label, rows, context->count, "-",
+               elapsed * 1000.0, key);
+    }
+    
+    for (int i = first; i < plan->step_count && (!context || context->count > 0); i++) {
+        const XPathPlanStep *step = &plan->steps[i];
+        StepChoice choice;
+        plan_step(doc, step, i > 0 ? step - 1 : NULL, ids, context ? context->count : -1, rows, named, 0, flat,
+                  &choice);
+        
+        double start = xml_time_now();
+        XPathResult *next = evaluate_step(doc, step, ids, context, &flat, &choice);
+        double elapsed = xml_time_now() - start;
+        
+        length = 0;
+        key[0] = '\0';
+        append_step_key(&key, &length, &capacity, plan, step);
+        printf("  %4d  %12.0f %12d %12.0f  %12.3f   %s ", i + 1, choice.rows, next->count, choice.cost,
+               elapsed * 1000.0, key);
+        print_step_access(step, &choice, context != NULL);
+        
+        rows = choice.rows;
+        named = choice.named;
+        free_xpath_result(context);
+        context = next;
+        if (context->count == 0 && i + 1 < plan->step_count) {
+            printf("  Contexto vacío: los pasos siguientes no se ejecutan\n");
+        }
+    }
+    
+    free_xpath_result(context);
+    free(key);
+    free(ids);
+}
+
+struct XPathCursor {
+    uint32_t *ids;
+    XPathResult *context;   // Pasos iniciales, del resumen de caminos si ya estaba al día
+    StepJoin *joins;        // Resto de pasos en curso, cada uno sobre el anterior
+    int join_count;
+    int done;
+};
+
+// Abrir un cursor: cada paso queda preparado sin producir nada y pide sus
+// nodos de contexto al anterior a medida que los necesita, así que quien deja
+// de pedir no termina ninguno. El resumen de caminos solo se usa si ya está
+// al día: construirlo recorrería el documento entero antes del primer nodo
+XPathCursor* xpath_cursor_open(const XPathPlan *plan, XMLDocument *doc) {
+    XPathCursor *cursor = (XPathCursor*)calloc(1, sizeof(XPathCursor));
+    cursor->done = 1;
+    if (!doc->root || plan->step_count == 0) return cursor;
+    
+    xml_number_nodes(doc);
+    cursor->ids = bind_plan_names(plan, &doc->names);
+    int flat = 1;
+    int first = 0;
+    if (index_current(doc, doc->path_summary.built, doc->path_summary.version)) {
+        first = leading_path_length(plan);
+        if (first > plan->step_count - 1) first = plan->step_count - 1;
+    }
+    if (first > 0) {
+        cursor->context = evaluate_steps(plan, doc, cursor->ids, first, &flat);
+        if (cursor->context->count == 0) return cursor;
+    }
+    
+    // Sin contar los nodos de un paso, el siguiente se planifica con sus
+    // filas estimadas
+    cursor->join_count = plan->step_count - first;
+    cursor->joins = (StepJoin*)calloc(cursor->join_count, sizeof(StepJoin));
+    StepJoin *source = NULL;
+    double rows = 0, named = 0;
+    for (int i = first; i < plan->step_count; i++) {
+        const XPathPlanStep *step = &plan->steps[i];
+        int context_count = source ? (rows > 1 ? (int)rows : 1) : cursor->context ? cursor->context->count : -1;
+        StepChoice choice;
+        plan_step(doc, step, i > 0 ? step - 1 : NULL, cursor->ids, context_count, rows, named, 1, flat, &choice);
+        if (choice.access == ACCESS_NONE) return cursor;
+        
+        StepJoin *join = &cursor->joins[i - first];
+        step_join_init(join, doc, step, cursor->ids, source ? NULL : cursor->context, source, &flat, &choice);
+        rows = choice.rows;
+        named = choice.named;
+        source = join;
+    }
+    cursor->done = 0;
+    return cursor;
+}
+
+XMLNode* xpath_cursor_next(XPathCursor *cursor) {
+    if (cursor->done) return NULL;
+    
+    XMLNode *node = step_join_next(&cursor->joins[cursor->join_count - 1], JOIN_NO_LIMIT);
+    if (!node) cursor->done = 1;
+    return node;
+}
+
+void xpath_cursor_close(XPathCursor *cursor) {
+    if (!cursor) return;
+    for (int i = 0; i < cursor->join_count; i++) {
+        free_step_join(&cursor->joins[i]);
+    }
+    free(cursor->joins);
+    free_xpath_result(cursor->context);
+    free(cursor->ids);
+    free(cursor);
+}
+
+// Primer nodo del resultado (NULL si no hay ninguno)
+XMLNode* xpath_first(const XPathPlan *plan, XMLDocument *doc) {
+    XPathCursor *cursor = xpath_cursor_open(plan, doc);
+    XMLNode *node = xpath_cursor_next(cursor);
+    xpath_cursor_close(cursor);
+    return node;
+}
+
+int xpath_exists(const XPathPlan *plan, XMLDocument *doc) {
+    return xpath_first(plan, doc) != NULL;
+}
+
+// Los primeros 'limit' nodos del resultado
+XPathResult* xpath_execute_limit(const XPathPlan *plan, XMLDocument *doc, int limit) {
+    XPathResult *result = init_xpath_result();
+    XPathCursor *cursor = xpath_cursor_open(plan, doc);
+    XMLNode *node;
+    while (result->count < limit && (node = xpath_cursor_next(cursor))) {
+        add_to_result(result, node);
+    }
+    xpath_cursor_close(cursor);
+    return result;
+}
+
+// Consultas que admite la evaluación paralela: un solo paso descendiente con
+// nombre o '*' y, opcionalmente, un predicado de atributo o de texto ("//a",
+// "//*[@a='v']", "//*[contains(text(),'x')]")
+int xpath_plan_parallel(const XPathPlan *plan) {
+    if (plan->step_count != 1) return 0;
+    const XPathPlanStep *step = &plan->steps[0];
+    return step->axis == AXIS_DESCENDANT && (step->kind == STEP_ELEMENT || step_has_predicate(step));
+}
+
+// Tramo del recorrido paralelo: 'count' hermanos consecutivos con todos sus
+// descendientes. Cada hilo llena el resultado de su tramo sin compartirlo
+typedef struct ParallelSegment {
+    const XPathPlanStep *step;
+    uint32_t name_id;
+    uint32_t attr_id;
+    XMLNode *first;
+    int count;
+    uint32_t size;          // Nodos del tramo
+    XPathResult result;
+} ParallelSegment;
+
+static void scan_segment_task(void *arg, int worker) {
+    ParallelSegment *segment = (ParallelSegment*)arg;
+    XMLNode *sibling = segment->first;
+    (void)worker;
+    
+    for (int i = 0; i < segment->count; i++, sibling = sibling->next) {
+        XMLTreeWalker walker;
+        XMLNode *node;
+        xml_walker_init(&walker, sibling);
+        while ((node = xml_walker_next(&walker))) {
+            if (step_matches(segment->step, node, segment->name_id, segment->attr_id)) {
+                add_to_result(&segment->result, node);
+            }
+        }
+    }
+}
+
+// Evaluar sin índices dividiendo el árbol en subárboles independientes. Los
+// nodos con más de 'grain' nodos en su subárbol se prueban aquí y se bajan a
+// sus hijos; los hermanos pequeños consecutivos forman un tramo que recorre
+// un hilo del pool. Los tramos salen en preorden, así que sus resultados
+// concatenados ya están en orden de documento y solo falta mezclarlos por pre
+// con los nodos probados aquí. La numeración se hace antes de repartir: los
+// hilos solo leen el árbol
+XPathResult* xpath_execute_parallel(const XPathPlan *plan, XMLDocument *doc, ThreadPool *pool) {
+    if (!pool || !doc->root || !xpath_plan_parallel(plan)) {
+        return xpath_execute(plan, doc);
+    }
+    
+    xml_number_nodes(doc);
+    uint32_t *ids = bind_plan_names(plan, &doc->names);
+    const XPathPlanStep *step = &plan->steps[0];
+    uint32_t name_id = bound_id(ids, step->name);
+    uint32_t attr_id = bound_id(ids, step->attr_name);
+    free(ids);
+    
+    XPathResult *result = init_xpath_result();
+    if ((!step->any_name && name_id == SYMBOL_NONE) ||
+        (step->kind == STEP_ATTRIBUTE && attr_id == SYMBOL_NONE)) {
+        return result;
+    }
+    
+    // Unos 16 tramos por hilo para que el robo de trabajo compense subárboles
+    // de tamaños distintos
+    uint32_t total = 0;
+    for (XMLNode *node = doc->root; node; node = node->next) {
+        total += node->size;
+    }
+    uint32_t grain = total / (uint32_t)(thread_pool_size(pool) * 16);
+    if (grain < 4096) grain = 4096;
+    
+    ParallelSegment *segments = NULL;
+    int segment_count = 0, segment_capacity = 0;
+    ParallelSegment *open = NULL;   // Tramo que aún admite hermanos
+    XPathResult inline_nodes = { NULL, 0, 0 };
+    
+    XMLNode *node = doc->root;
+    while (node) {
+        if (node->size > grain) {
+            if (step_matches(step, node, name_id, attr_id)) add_to_result(&inline_nodes, node);
+            open = NULL;
+            if (node->children) {
+                node = node->children;
+                continue;
+            }
         } else {
-            // Consulta simple de elemento
-            if (strcmp(token, "*") == 0) {
-                // Todos los elementos
-                find_by_element_name(current_context, "*", temp_result);
-            } else {
-                find_by_element_name(current_context, token, temp_result);
+            if (!open || open->size + node->size > grain) {
+                if (segment_count == segment_capacity) {
+                    segment_capacity = segment_capacity ? segment_capacity * 2 : 64;
+                    segments = (ParallelSegment*)realloc(segments, segment_capacity * sizeof(ParallelSegment));
+                }
+                open = &segments[segment_count++];
+                open->step = step;
+                open->name_id = name_id;
+                open->attr_id = attr_id;
+                open->first = node;
+                open->count = 0;
+                open->size = 0;
+                open->result.nodes = NULL;
+                open->result.count = 0;
+                open->result.capacity = 0;
+            }
+            open->count++;
+            open->size += node->size;
+        }
+        
+        // Siguiente nodo tras el subárbol; al subir se cierra el tramo
+        while (node && !node->next) {
+            node = node->parent;
+            open = NULL;
+        }
+        if (node) node = node->next;
+    }
+    
+    for (int i = 0; i < segment_count; i++) {
+        thread_pool_submit(pool, scan_segment_task, &segments[i]);
+    }
+    thread_pool_wait(pool);
+    
+    int found = inline_nodes.count;
+    for (int i = 0; i < segment_count; i++) {
+        found += segments[i].result.count;
+    }
+    if (found > 0) {
+        result->nodes = (XMLNode**)malloc(found * sizeof(XMLNode*));
+        result->capacity = found;
+    }
+    
+    int next_inline = 0;
+    for (int i = 0; i < segment_count; i++) {
+        XPathResult *part = &segments[i].result;
+        for (int j = 0; j < part->count; j++) {
+            while (next_inline < inline_nodes.count && inline_nodes.nodes[next_inline]->pre < part->nodes[j]->pre) {
+                result->nodes[result->count++] = inline_nodes.nodes[next_inline++];
             }
+            result->nodes[result->count++] = part->nodes[j];
+        }
+        free(part->nodes);
+    }
+    while (next_inline < inline_nodes.count) {
+        result->nodes[result->count++] = inline_nodes.nodes[next_inline++];
+    }
+    
+    free(inline_nodes.nodes);
+    free(segments);
+    return result;
+}
+
+// Evaluar un paso sobre el árbol compacto. Los índices ya siguen el orden de
+// documento y cada subárbol es un rango [nodo, fin), así que el eje
+// descendiente es una mezcla de los candidatos con los rangos del contexto
+static CompactResult* evaluate_compact_step(CompactTree *tree, const XPathPlanStep *step,
+                                            const uint32_t *ids, CompactResult *context) {
+    CompactResult *result = init_compact_result();
+    uint32_t name_id = bound_id(ids, step->name);
+    uint32_t attr_id = bound_id(ids, step->attr_name);
+    
+    if (step->kind == STEP_INVALID || (!step->any_name && name_id == SYMBOL_NONE) ||
+        (step->kind == STEP_ATTRIBUTE && attr_id == SYMBOL_NONE)) {
+        return result;
+    }
+    
+    uint8_t *members = NULL;
+    if (context && step->axis == AXIS_CHILD) {
+        members = (uint8_t*)calloc(tree->node_count, 1);
+        for (int i = 0; i < context->count; i++) {
+            members[context->nodes[i]] = 1;
         }
+    }
+    uint32_t *positions = NULL;
+    if (step->kind == STEP_POSITION) {
+        positions = (uint32_t*)calloc(tree->node_count, sizeof(uint32_t));
+    }
+    
+    int next = 0;                   // Siguiente nodo del contexto por mezclar
+    uint32_t covered_end = 0;       // Fin de los rangos del contexto ya abiertos
+    
+    for (uint32_t i = 0; i < tree->node_count; i++) {
+        if (tree->type[i] != NODE_ELEMENT) continue;
+        if (!step->any_name && tree->name[i] != name_id) continue;
         
-        // Actualizar contexto para próxima iteración
-        if (temp_result->count > 0) {
-            // Por simplicidad, usar el primer resultado como contexto
-            current_context = temp_result->nodes[0];
+        if (step->kind == STEP_ATTRIBUTE) {
+            uint32_t first = tree->span_start[i];
+            uint32_t last = first + tree->span_length[i];
+            uint32_t a;
+            for (a = first; a < last; a++) {
+                if (tree->attr_name[a] == attr_id &&
+                    (!step->attr_value || strcmp(tree->text + tree->attr_value[a], step->attr_value) == 0)) {
+                    break;
+                }
+            }
+            if (a == last) continue;
+        }
+        if (step->kind == STEP_CONTAINS || step->kind == STEP_TOKEN) {
+            uint32_t child = tree->first_child[i];
+            while (child != COMPACT_NONE &&
+                   ((tree->type[child] != NODE_TEXT && tree->type[child] != NODE_CDATA) ||
+                    !xml_text_contains(tree->text + tree->span_start[child], step->search, step->kind == STEP_TOKEN))) {
+                child = tree->next_sibling[child];
+            }
+            if (child == COMPACT_NONE) continue;
         }
         
-        // Combinar resultados
-        for (int i = 0; i < temp_result->count; i++) {
-            add_to_result(result, temp_result->nodes[i]);
+        uint32_t parent = tree->parent[i];
+        if (!context) {
+            if (step->axis == AXIS_CHILD && i != 0) continue;
+        } else if (parent == COMPACT_NONE) {
+            continue;
+        } else if (members) {
+            if (!members[parent]) continue;
+        } else {
+            // Rangos anidados o disjuntos: uno contenido en el ya abierto no
+            // lo amplía y no hace falta calcular su fin
+            while (next < context->count && context->nodes[next] < i) {
+                uint32_t node = context->nodes[next++];
+                if (node >= covered_end) covered_end = compact_subtree_end(tree, node);
+            }
+            if (i >= covered_end) continue;
         }
         
-        free_xpath_result(temp_result);
-        token = strtok(NULL, "/");
+        if (step->kind == STEP_POSITION && step->position == XPATH_POSITION_LAST) {
+            uint32_t sibling = tree->next_sibling[i];
+            while (sibling != COMPACT_NONE &&
+                   (tree->type[sibling] != NODE_ELEMENT || (!step->any_name && tree->name[sibling] != name_id))) {
+                sibling = tree->next_sibling[sibling];
+            }
+            if (sibling != COMPACT_NONE) continue;
+        } else if (positions) {
+            uint32_t position = parent == COMPACT_NONE ? 1 : ++positions[parent];
+            if ((int)position != step->position) continue;
+        }
+        add_compact_result(result, i);
+    }
+    
+    free(members);
+    free(positions);
+    return result;
+}
+
+// Ejecutar un plan sobre el árbol compacto con las mismas reglas
+CompactResult* xpath_execute_compact(const XPathPlan *plan, CompactTree *tree) {
+    if (tree->node_count == 0 || plan->step_count == 0) return init_compact_result();
+    
+    uint32_t *ids = bind_plan_names(plan, tree->names);
+    CompactResult *context = NULL;
+    
+    for (int i = 0; i < plan->step_count; i++) {
+        CompactResult *next = evaluate_compact_step(tree, &plan->steps[i], ids, context);
+        free_compact_result(context);
+        context = next;
+        if (context->count == 0) break;
     }
     
-    free(xpath_copy);
+    free(ids);
+    return context;
+}
+
+// Compilar y ejecutar una consulta de una sola vez
+XPathResult* xpath_query(XMLDocument *doc, const char *xpath) {
+    if (!xpath) return init_xpath_result();
+    
+    XPathPlan *plan = xpath_compile(xpath);
+    XPathResult *result = xpath_execute(plan, doc);
+    free_xpath_plan(plan);
+    return result;
+}
+
+CompactResult* xpath_query_compact(CompactTree *tree, const char *xpath) {
+    if (!xpath) return init_compact_result();
+    
+    XPathPlan *plan = xpath_compile(xpath);
+    CompactResult *result = xpath_execute_compact(plan, tree);
+    free_xpath_plan(plan);
     return result;
 }
 
 // Funciones auxiliares para XPath
-void print_xpath_results_extended(XPathResult *result) {
+// Imprimir un nodo del resultado con su contenido de texto y su ruta
+static void print_result_node(XMLNode *node, int number) {
+    printf("\n--- Resultado %d ---\n", number);
+    
+    if (node->type == NODE_ELEMENT) {
+        printf("Elemento: <%s", node->name);
+        
+        if (node->attributes) {
+            Attribute *attr = node->attributes->first;
+            while (attr) {
+                printf(" %s=\"%s\"", attr->name, attr->value);
+                attr = attr->next;
+            }
+        }
+        printf(">\n");
+        
+        // Mostrar contenido de texto si existe
+        XMLNode *child = node->children;
+        while (child) {
+            if (child->type == NODE_TEXT) {
+                printf("Contenido: %s\n", child->content);
+            }
+            child = child->next;
+        }
+        
+        // Mostrar ruta del elemento
+        printf("Ruta: ");
+        XMLNode *parent = node->parent;
+        char path[1000] = "";
+        char temp[100];
+        
+        // Construir ruta hacia arriba
+        while (parent) {
+            snprintf(temp, sizeof(temp), "/%s", parent->name);
+            if (strlen(path) + strlen(temp) >= sizeof(path)) break;
+            memmove(path + strlen(temp), path, strlen(path) + 1);
+            memcpy(path, temp, strlen(temp));
+            parent = parent->parent;
+        }
+        printf("%s/%s\n", path, node->name);
+    }
+}
+
+void print_xpath_results(XPathResult *result) {
+    if (!result || result->count == 0) {
+        printf("No se encontraron resultados.\n");
+        return;
+    }
+    
+    printf("Encontrados %d resultado(s):\n", result->count);
+    for (int i = 0; i < result->count; i++) {
+        print_result_node(result->nodes[i], i + 1);
+    }
+}
+
+// Los nodos se imprimen según llegan del cursor, sin reunir el resultado
+int print_xpath_cursor(XPathCursor *cursor, int limit) {
+    int count = 0;
+    XMLNode *node;
+    while (count < limit && (node = xpath_cursor_next(cursor))) {
+        print_result_node(node, ++count);
+    }
+    return count;
+}
+
+// Imprimir resultados del árbol compacto
+void print_compact_results(CompactTree *tree, CompactResult *result) {
     if (!result || result->count == 0) {
         printf("No se encontraron resultados.\n");
         return;
@@ -215,58 +1798,59 @@ void print_xpath_results_extended(XPathResult *result) {
     
     printf("Encontrados %d resultado(s):\n", result->count);
     for (int i = 0; i < result->count; i++) {
-        XMLNode *node = result->nodes[i];
+        uint32_t node = result->nodes[i];
         printf("\n--- Resultado %d ---\n", i + 1);
         
-        if (node->type == NODE_ELEMENT) {
-            printf("Elemento: <%s", node->name);
-            
-            if (node->attributes) {
-                Attribute *attr = node->attributes->first;
-                while (attr) {
-                    printf(" %s=\"%s\"", attr->name, attr->value);
-                    attr = attr->next;
-                }
-            }
-            printf(">\n");
-            
-            // Mostrar contenido de texto si existe
-            XMLNode *child = node->children;
-            while (child) {
-                if (child->type == NODE_TEXT) {
-                    printf("Contenido: %s\n", child->content);
-                }
-                child = child->next;
-            }
-            
-            // Mostrar ruta del elemento
-            printf("Ruta: ");
-            XMLNode *parent = node->parent;
-            char path[1000] = "";
-            char temp[100];
-            
-            // Construir ruta hacia arriba
-            while (parent) {
-                snprintf(temp, sizeof(temp), "/%s", parent->name);
-                memmove(path + strlen(temp), path, strlen(path) + 1);
-                memcpy(path, temp, strlen(temp));
-                parent = parent->parent;
+        if (tree->type[node] != NODE_ELEMENT) continue;
+        
+        printf("Elemento: <%s", compact_node_name(tree, node));
+        uint32_t first = tree->span_start[node];
+        for (uint32_t a = first; a < first + tree->span_length[node]; a++) {
+            printf(" %s=\"%s\"", symbol_name(tree->names, tree->attr_name[a]), tree->text + tree->attr_value[a]);
+        }
+        printf(">\n");
+        
+        // Mostrar contenido de texto si existe
+        for (uint32_t child = tree->first_child[node]; child != COMPACT_NONE; child = tree->next_sibling[child]) {
+            if (tree->type[child] == NODE_TEXT) {
+                printf("Contenido: %s\n", compact_node_text(tree, child));
             }
-            printf("%s/%s\n", path, node->name);
         }
+        
+        // Mostrar ruta del elemento
+        printf("Ruta: ");
+        char path[1000] = "";
+        char temp[100];
+        for (uint32_t parent = tree->parent[node]; parent != COMPACT_NONE; parent = tree->parent[parent]) {
+            snprintf(temp, sizeof(temp), "/%s", compact_node_name(tree, parent));
+            if (strlen(path) + strlen(temp) >= sizeof(path)) break;
+            memmove(path + strlen(temp), path, strlen(path) + 1);
+            memcpy(path, temp, strlen(temp));
+        }
+        printf("%s/%s\n", path, compact_node_name(tree, node));
     }
 }
 
 // Modo interactivo extendido para XPath
-void xpath_interactive_mode_extended(XMLNode *root) {
+void xpath_interactive_mode(XMLDocument *doc, size_t cache_bytes) {
     char xpath[512];
+    QueryCache cache;
+    init_query_cache(&cache, cache_bytes);
     
-    printf("\nModo consulta XPath extendido\n");
+    printf("\nModo consulta XPath (escriba 'quit' para salir):\n");
     printf("Comandos disponibles:\n");
     printf("  /elemento          - Buscar elemento desde raíz\n");
     printf("  //elemento         - Buscar elemento en todo el documento\n");
     printf("  elemento[@attr='valor'] - Buscar por atributo\n");
     printf("  elemento[1]        - Buscar por posición\n");
+    printf("  elemento[last()]   - Último de sus hermanos\n");
+    printf("  elemento[contains(text(),'x')] - Con texto que contiene 'x'\n");
+    printf("  elemento[contains-token(text(),'x')] - Con la palabra 'x' en su texto\n");
+    printf("  <consulta> LIMIT n - Solo los primeros n resultados\n");
+    printf("  exists <consulta>  - ¿Hay algún resultado?\n");
+    printf("  explain <consulta> - Plan elegido, con filas estimadas y reales\n");
+    printf("  stats              - Estadísticas de la caché de resultados\n");
+    printf("  cache <KB>         - Límite de memoria de la caché (0 = desactivada)\n");
     printf("  help               - Mostrar ayuda\n");
     printf("  quit               - Salir\n\n");
     
@@ -290,6 +1874,28 @@ void xpath_interactive_mode_extended(XMLNode *root) {
             printf("  /root/libro[1]     - Primer libro\n");
             printf("  //libro[@id='1']   - Libro con id='1'\n");
             printf("  //*[@genero='ficcion'] - Elementos con genero='ficcion'\n");
+            printf("  //titulo[contains(text(),'Quijote')] - Títulos que contienen 'Quijote'\n");
+            continue;
+        }
+        
+        if (strcmp(xpath, "stats") == 0) {
+            print_query_cache_stats(&cache);
+            continue;
+        }
+        
+        if (strncmp(xpath, "cache ", 6) == 0) {
+            // Solo un número de KB no negativo; 0 desactiva la caché
+            char *end;
+            errno = 0;
+            long kb = strtol(xpath + 6, &end, 10);
+            while (isspace((unsigned char)*end)) end++;
+            if (end == xpath + 6 || *end != '\0' || errno == ERANGE || kb < 0 ||
+                (unsigned long)kb > SIZE_MAX / 1024) {
+                printf("Límite no válido: '%s' (KB, 0 = desactivada)\n", xpath + 6);
+                continue;
+            }
+            query_cache_set_limit(&cache, (size_t)kb * 1024);
+            printf("Límite de la caché: %zu KB\n", cache.max_bytes / 1024);
             continue;
         }
         
@@ -297,8 +1903,46 @@ void xpath_interactive_mode_extended(XMLNode *root) {
             continue;
         }
         
-        XPathResult *results = xpath_query_extended(root, xpath);
-        print_xpath_results_extended(results);
+        // exists y LIMIT usan un cursor, que deja de recorrer en cuanto tiene
+        // los nodos pedidos (sin pasar por la caché)
+        if (strncmp(xpath, "exists ", 7) == 0) {
+            XPathPlan *plan = xpath_compile(xpath + 7);
+            double start = xml_time_now();
+            int exists = xpath_exists(plan, doc);
+            printf("%s (%.1f µs)\n", exists ? "Sí" : "No", (xml_time_now() - start) * 1e6);
+            free_xpath_plan(plan);
+            continue;
+        }
+        
+        if (strncmp(xpath, "explain ", 8) == 0) {
+            XPathPlan *plan = xpath_compile(xpath + 8);
+            print_xpath_explain(plan, doc);
+            free_xpath_plan(plan);
+            continue;
+        }
+        
+        char *limit = strstr(xpath, " LIMIT ");
+        if (limit) {
+            *limit = '\0';
+            int max = atoi(limit + 7);
+            XPathPlan *plan = xpath_compile(xpath);
+            XPathCursor *cursor = xpath_cursor_open(plan, doc);
+            int count = print_xpath_cursor(cursor, max);
+            if (count == 0) {
+                printf("No se encontraron resultados.\n");
+            } else {
+                printf("\nMostrados %d resultado(s)%s\n", count,
+                       count == max && xpath_cursor_next(cursor) ? " (hay más)" : "");
+            }
+            xpath_cursor_close(cursor);
+            free_xpath_plan(plan);
+            continue;
+        }
+        
+        XPathResult *results = query_cache_query(&cache, doc, xpath);
+        print_xpath_results(results);
         free_xpath_result(results);
     }
-}
\ No newline at end of file
+    
+    free_query_cache(&cache);
+}
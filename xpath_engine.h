@@ -0,0 +1,136 @@
+#ifndef XPATH_ENGINE_H
+#define XPATH_ENGINE_H
+
+#include "xml_tree.h"
+#include "compact_tree.h"
+#include "thread_pool.h"
+
+// Estructura para resultados de XPath
+typedef struct XPathResult {
+    XMLNode **nodes;
+    int count;
+    int capacity;
+} XPathResult;
+
+// Tipo de paso de una consulta XPath
+typedef enum {
+    STEP_ELEMENT,       // elemento
+    STEP_ATTRIBUTE,     // elemento[@atributo='valor'] o elemento[@atributo]
+    STEP_POSITION,      // elemento[n]
+    STEP_TEXT,          // text()
+    STEP_CONTAINS,      // elemento[contains(text(),'texto')]
+    STEP_TOKEN,         // elemento[contains-token(text(),'palabra')]
+    STEP_INVALID        // Predicado sin cerrar: sin resultados
+} XPathStepKind;
+
+// Eje de un paso: '/' hijos del contexto, '//' descendientes
+typedef enum {
+    AXIS_CHILD,
+    AXIS_DESCENDANT
+} XPathAxis;
+
+// Posición de [last()]: el último de los hermanos que pasan la prueba de nombre
+#define XPATH_POSITION_LAST (-1)
+
+// Paso compilado: los nombres son IDs de la tabla de símbolos del plan
+typedef struct XPathPlanStep {
+    XPathStepKind kind;
+    XPathAxis axis;
+    int any_name;           // Prueba de nombre '*'
+    uint32_t name;          // Nombre del elemento (SYMBOL_NONE si no aplica)
+    uint32_t attr_name;     // Atributo del predicado (SYMBOL_NONE si no aplica)
+    char *attr_value;       // NULL = solo presencia del atributo
+    int position;           // n >= 1 o XPATH_POSITION_LAST
+    char *search;           // Texto buscado por contains() y contains-token()
+} XPathPlanStep;
+
+// Plan de consulta: se compila una vez y queda inmutable, así que puede
+// guardarse y ejecutarse muchas veces, sobre muchos documentos y desde varios
+// hilos a la vez. Al ejecutarlo, sus nombres se traducen a los IDs del
+// documento con una búsqueda por nombre distinto
+typedef struct XPathPlan {
+    char *source;           // Expresión original
+    char *text;             // Copia dividida en pasos (valores de predicados)
+    XPathPlanStep *steps;
+    int step_count;
+    SymbolTable names;      // Nombres de la consulta
+} XPathPlan;
+
+// Funciones de resultados
+XPathResult* init_xpath_result(void);
+void add_to_result(XPathResult *result, XMLNode *node);
+void free_xpath_result(XPathResult *result);
+
+// Búsquedas sobre el árbol de punteros (nombres como IDs de la tabla de
+// símbolos del documento; SYMBOL_NONE no encuentra nada)
+void find_by_element_name(XMLNode *node, uint32_t name_id, XPathResult *result);
+void find_by_attribute(XMLNode *node, uint32_t attr_id, const char *attr_value, XPathResult *result);
+void find_direct_children(XMLNode *parent, uint32_t name_id, XPathResult *result);
+void find_by_position(XMLNode *parent, uint32_t name_id, int position, XPathResult *result);
+void find_by_text_content(XMLNode *node, const char *text, XPathResult *result);
+
+// Búsquedas sobre el árbol compacto (mismas reglas, índices en lugar de punteros)
+void compact_find_by_element_name(CompactTree *tree, uint32_t node, uint32_t name_id, CompactResult *result);
+void compact_find_by_attribute(CompactTree *tree, uint32_t node, uint32_t attr_id,
+                               const char *attr_value, CompactResult *result);
+void compact_find_direct_children(CompactTree *tree, uint32_t parent, uint32_t name_id, CompactResult *result);
+void compact_find_by_position(CompactTree *tree, uint32_t parent, uint32_t name_id, int position,
+                              CompactResult *result);
+void compact_find_by_text_content(CompactTree *tree, uint32_t node, const char *text, CompactResult *result);
+
+// Planes de consulta. La ejecución evalúa cada paso sobre todo el conjunto de
+// nodos del paso anterior, con el acceso de menor coste estimado, y devuelve
+// el del último, en orden de documento y sin duplicados. Los predicados de
+// texto miran los hijos de texto y CDATA del elemento; se resuelven con el
+// índice de texto del documento, que se construye en la primera consulta que
+// lo necesita
+XPathPlan* xpath_compile(const char *xpath);
+void free_xpath_plan(XPathPlan *plan);
+XPathResult* xpath_execute(const XPathPlan *plan, XMLDocument *doc);
+// Compilar las consultas de un archivo, una por línea (se ignoran las vacías
+// y las que empiezan con '#'); 'compile_seconds' recibe el tiempo de
+// compilación. Devuelve NULL si no se pudo abrir
+XPathPlan** xpath_load_plans(const char *path, int *count, double *compile_seconds);
+void free_xpath_plans(XPathPlan **plans, int count);
+// Cursor sobre el resultado de un plan: los pasos anteriores al último se
+// evalúan completos y el último produce sus nodos, en orden de documento, a
+// medida que se piden. Quien deja de pedir (primer nodo, exists, LIMIT) no
+// recorre el resto, y si los índices del último paso no están construidos se
+// recorre el árbol en lugar de construirlos. El documento no debe cambiar
+// mientras el cursor esté abierto
+typedef struct XPathCursor XPathCursor;
+XPathCursor* xpath_cursor_open(const XPathPlan *plan, XMLDocument *doc);
+XMLNode* xpath_cursor_next(XPathCursor *cursor);
+void xpath_cursor_close(XPathCursor *cursor);
+XMLNode* xpath_first(const XPathPlan *plan, XMLDocument *doc);
+int xpath_exists(const XPathPlan *plan, XMLDocument *doc);
+XPathResult* xpath_execute_limit(const XPathPlan *plan, XMLDocument *doc, int limit);
+// EXPLAIN: ejecutar el plan paso a paso e imprimir el acceso que eligió el
+// planificador para cada uno (recorrido, hijos, índice de nombres, de
+// atributos o de texto, y unión con el contexto) con su coste y las filas
+// estimadas y reales. Las estimaciones usan las estadísticas de la tabla
+// semántica del documento (XMLDocument.statistics) si siguen al día
+void print_xpath_explain(const XPathPlan *plan, XMLDocument *doc);
+// Forma normalizada del plan ("libro" y "//libro", o comillas distintas, dan
+// la misma); la cadena devuelta se libera con free
+char* xpath_plan_key(const XPathPlan *plan);
+CompactResult* xpath_execute_compact(const XPathPlan *plan, CompactTree *tree);
+
+// Evaluación paralela sin índices para "//a", "//*[@a='v']" y
+// "//*[contains(text(),'x')]" (ver xpath_plan_parallel): el árbol se reparte por subárboles entre los hilos
+// del pool y los resultados se mezclan en orden de documento. Con otras
+// consultas, o sin pool, equivale a xpath_execute
+int xpath_plan_parallel(const XPathPlan *plan);
+XPathResult* xpath_execute_parallel(const XPathPlan *plan, XMLDocument *doc, ThreadPool *pool);
+
+// Consultas de una sola vez (compilar, ejecutar y liberar el plan)
+XPathResult* xpath_query(XMLDocument *doc, const char *xpath);
+CompactResult* xpath_query_compact(CompactTree *tree, const char *xpath);
+void print_xpath_results(XPathResult *result);
+// Imprimir hasta 'limit' nodos de un cursor; devuelve cuántos se imprimieron
+int print_xpath_cursor(XPathCursor *cursor, int limit);
+void print_compact_results(CompactTree *tree, CompactResult *result);
+// Modo interactivo con una caché de resultados de 'cache_bytes' bytes
+void xpath_interactive_mode(XMLDocument *doc, size_t cache_bytes);
+
+#endif